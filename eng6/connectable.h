@@ -156,36 +156,48 @@ namespace sel {
 		typedef std::vector<T> vector_t;
 	private:
 		 vector_t v_;
+		size_t width_;
+		size_t frames_ = 1;
 		mutable bool frozen = false;
+		// freezewidth() only fixes the width;  the frame count is fixed when the port itself is frozen
+		bool frames_frozen = false;
 	public:
 		template<typename>friend class Connectable; // allow Connectable to upcast
 
 		static constexpr auto INVALID_VALUE() { return std::numeric_limits<T>::quiet_NaN(); }
 
-		void freeze() { frozen = true; }
+		void freeze() { frozen = true; frames_frozen = true; }
 		// width can never be zero
-		explicit port_t(size_t width = 1) : v_(width ? width : 1, INVALID_VALUE()) {  }
+		explicit port_t(size_t width = 1) : v_(width ? width : 1, INVALID_VALUE()), width_(v_.size()) {  }
 
-		template<class IT>port_t(IT first, IT last) : v_(first, last) {}
+		template<class IT>port_t(IT first, IT last) : v_(first, last), width_(v_.size()) {}
 
-		// width() is alias for size()
-		constexpr size_t width() const { return v_.size(); }
+		// width() is the width of one frame
+		constexpr size_t width() const { return width_; }
+
+		void setwidth(size_t w) { if (frozen && w != width()) throw sp_ex_portwidth_frozen();  width_ = w; v_.resize(w * frames_, INVALID_VALUE()); }
+		void freezewidth(size_t w) { if (frozen && w != width()) throw sp_ex_portwidth_frozen();  width_ = w; v_.resize(w * frames_, INVALID_VALUE());  frozen = true; }
 
-		void setwidth(size_t w) { if (frozen && w != width()) throw sp_ex_portwidth_frozen();  v_.resize(w, INVALID_VALUE()); }
-		void freezewidth(size_t w) { if (frozen && w != width()) throw sp_ex_portwidth_frozen();  v_.resize(w, INVALID_VALUE());  freeze(); }
+		// For block processing, the port can hold several consecutive frames:  frame k is at as_array() + k * width().
+		// Set before the processors reading and writing the port are frozen (it moves the data);  once the port is frozen,
+		// changing it throws, as setwidth() does.
+		size_t frames() const { return frames_; }
+		void setframes(size_t n) { if (!n) n = 1; if (frames_frozen && n != frames_) throw sp_ex_portwidth_frozen();  frames_ = n; v_.resize(width_ * frames_, INVALID_VALUE()); }
 
 		// as_array is alias for data()
 		T *as_array() { return v_.data(); }
 
-		std::vector<T> as_vector() { return v_;  }
+		// the first frame
+		std::vector<T> as_vector() { return std::vector<T>(begin(), end());  }
+		// all frames
 		std::vector<T>& as_vector_ref() { return v_;  }
 
 		const T *as_array() const { return v_.data(); }
 
 		auto begin() { return v_.begin(); }
-		auto end() { return v_.end(); }
+		auto end() { return v_.begin() + width_; }
 		auto begin() const { return v_.begin(); }
-		auto end() const { return v_.end(); }
+		auto end() const { return v_.begin() + width_; }
 	};
 
 	template<class T, size_t W>struct port_t<T, W, false> 
@@ -221,6 +233,10 @@ namespace sel {
 		void setwidth(size_t w) { if (w != width()) throw sp_ex_portwidth_frozen();  }
 		void freezewidth(size_t w) { if (w != width()) throw sp_ex_portwidth_frozen();  }
 
+		// fixed size ports hold one frame
+		constexpr size_t frames() const { return 1; }
+		void setframes(size_t n) { if (n != 1) throw sp_ex_port_size();  }
+
 		// as_array is alias for data()
 		samp_t *as_array() { return v_.data(); }
 
@@ -252,36 +268,48 @@ namespace sel {
 		typedef std::vector<T> vector_t;
 	private:
 		 vector_t v_;
+		size_t width_;
+		size_t frames_ = 1;
 		mutable bool frozen = false;
+		// freezewidth() only fixes the width;  the frame count is fixed when the port itself is frozen
+		bool frames_frozen = false;
 	public:
 		template<typename>friend class Connectable; // allow Connectable to upcast
 
 		static constexpr auto INVALID_VALUE() { return std::numeric_limits<T>::quiet_NaN(); }
 
-		void freeze() { frozen = true; }
+		void freeze() { frozen = true; frames_frozen = true; }
 		// width can never be zero
-		explicit port_t(size_t width = 1) : v_(width ? width : 1, INVALID_VALUE()) {  }
+		explicit port_t(size_t width = 1) : v_(width ? width : 1, INVALID_VALUE()), width_(v_.size()) {  }
 
-		template<class IT>port_t(IT first, IT last) : v_(first, last) {}
+		template<class IT>port_t(IT first, IT last) : v_(first, last), width_(v_.size()) {}
 
-		// width() is alias for size()
-		constexpr size_t width() const { return v_.size(); }
+		// width() is the width of one frame
+		constexpr size_t width() const { return width_; }
+
+		void setwidth(size_t w) { if (frozen && w != width()) throw sp_ex_portwidth_frozen();  width_ = w; v_.resize(w * frames_, INVALID_VALUE()); }
+		void freezewidth(size_t w) { if (frozen && w != width()) throw sp_ex_portwidth_frozen();  width_ = w; v_.resize(w * frames_, INVALID_VALUE());  frozen = true; }
 
-		void setwidth(size_t w) { if (frozen && w != width()) throw sp_ex_portwidth_frozen();  v_.resize(w, INVALID_VALUE()); }
-		void freezewidth(size_t w) { if (frozen && w != width()) throw sp_ex_portwidth_frozen();  v_.resize(w, INVALID_VALUE());  freeze(); }
+		// For block processing, the port can hold several consecutive frames:  frame k is at as_array() + k * width().
+		// Set before the processors reading and writing the port are frozen (it moves the data);  once the port is frozen,
+		// changing it throws, as setwidth() does.
+		size_t frames() const { return frames_; }
+		void setframes(size_t n) { if (!n) n = 1; if (frames_frozen && n != frames_) throw sp_ex_portwidth_frozen();  frames_ = n; v_.resize(width_ * frames_, INVALID_VALUE()); }
 
 		// as_array is alias for data()
 		T *as_array() { return v_.data(); }
 
-		std::vector<T> as_vector() { return v_;  }
+		// the first frame
+		std::vector<T> as_vector() { return std::vector<T>(begin(), end());  }
+		// all frames
 		std::vector<T>& as_vector_ref() { return v_;  }
 
 		const T *as_array() const { return v_.data(); }
 
 		auto begin() { return v_.begin(); }
-		auto end() { return v_.end(); }
+		auto end() { return v_.begin() + width_; }
 		auto begin() const { return v_.begin(); }
-		auto end() const { return v_.end(); }
+		auto end() const { return v_.begin() + width_; }
 	};
 
 	template<class T, size_t W>struct port_t<T, W, false> 
@@ -317,6 +345,10 @@ namespace sel {
 		void setwidth(size_t w) { if (w != width()) throw sp_ex_portwidth_frozen();  }
 		void freezewidth(size_t w) { if (w != width()) throw sp_ex_portwidth_frozen();  }
 
+		// fixed size ports hold one frame
+		constexpr size_t frames() const { return 1; }
+		void setframes(size_t n) { if (n != 1) throw sp_ex_port_size();  }
+
 		// as_array is alias for data()
 		samp_t *as_array() { return v_.data(); }
 
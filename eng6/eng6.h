@@ -9,6 +9,8 @@
 #include "wavfile.h"
 #include "factory.h"
 #include "scheduler.h"
+#include "spsc_queue.h"
+#include "mpmc_queue.h"
 #include "file_input_stream.h"
 #include "websocket_stream.h"
 #include "procs/data_source.h"
@@ -19,6 +21,7 @@
 #include "procs/numpy_file_writer.h"
 #include "procs/numpy_file_reader.h"
 #include "procs/mux_demux.h"
+#include "procs/fan_in.h"
 #include "procs/resampler.h"
 
 #include "procs/expr.h"
@@ -34,9 +37,11 @@
 #include "procs/dct.h"
 #include "procs/fft.h"
 #include "procs/ac.h"
+#include "procs/sdft.h"
 #include "procs/psd.h"
 #include "procs/mag.h"
 #include "procs/melspec.h"
+#include "procs/mfcc.h"
 #include "procs/lpc.h"
 #include "procs/dnn.h"
 #include "procs/ewma.h"
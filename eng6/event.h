@@ -4,11 +4,142 @@
 #include "rate_measure.h"
 
 #include <iostream> // for trace
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include <boost/asio.hpp>
 #include <boost/asio/high_resolution_timer.hpp>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace sel {
 	namespace eng6 {
+		/*
+		A scheduler's ready list:  one bit per schedule, in the order the schedules were added.
+		A semaphore attached to the list sets its schedule's bit when it is raised, so the scheduler visits only the
+		schedules whose triggers have been raised, in the same order as it would by walking all of them.
+
+		A shared list belongs to one worker of a multi-threaded scheduler, and its bits may be set from other threads
+		(e.g. by a timer handler run by the thread servicing async I/O).  Its words are updated with atomic read-modify-writes,
+		and its worker can park() until a bit is set.  A list that isn't shared is only used by one thread, and its words are
+		updated with plain loads and stores.
+		*/
+		class ready_list
+		{
+			std::unique_ptr<std::atomic<uint64_t>[]> words_;
+			size_t nwords_ = 0;
+			const bool shared_;
+
+			// a parked worker waits on this
+			std::mutex park_mutex_;
+			std::condition_variable park_cv_;
+			std::atomic<bool> parked_{ false };
+
+			static size_t lowest_bit_(uint64_t bits)
+			{
+#if defined(_MSC_VER)
+				unsigned long i;
+				_BitScanForward64(&i, bits);
+				return i;
+#else
+				return static_cast<size_t>(__builtin_ctzll(bits));
+#endif
+			}
+
+			void clear_bit_(size_t w, uint64_t bit)
+			{
+				if (shared_)
+					words_[w].fetch_and(~bit, std::memory_order_acq_rel);
+				else
+					words_[w].store(words_[w].load(std::memory_order_relaxed) & ~bit, std::memory_order_relaxed);
+			}
+
+		public:
+			static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+			explicit ready_list(bool shared = false) : shared_(shared) {}
+
+			bool shared() const { return shared_; }
+
+			// grow to hold slots bits.  Not while other threads are setting bits
+			void resize(size_t slots)
+			{
+				const size_t nwords = (slots + 63) / 64;
+				if (nwords <= nwords_)
+					return;
+				std::unique_ptr<std::atomic<uint64_t>[]> words(new std::atomic<uint64_t>[nwords]);
+				for (size_t w = 0; w < nwords; ++w)
+					words[w].store(w < nwords_ ? words_[w].load(std::memory_order_relaxed) : 0, std::memory_order_relaxed);
+				words_ = std::move(words);
+				nwords_ = nwords;
+			}
+
+			void set(size_t slot)
+			{
+				const uint64_t bit = uint64_t(1) << (slot % 64);
+				auto& word = words_[slot / 64];
+				if (!shared_) {
+					word.store(word.load(std::memory_order_relaxed) | bit, std::memory_order_relaxed);
+					return;
+				}
+				word.fetch_or(bit, std::memory_order_seq_cst);
+				if (parked_.load(std::memory_order_seq_cst)) {
+					std::lock_guard<std::mutex> lock(park_mutex_);
+					park_cv_.notify_one();
+				}
+			}
+
+			// find the first set bit at or after from, clear it, and return its slot (npos if none)
+			size_t take(size_t from)
+			{
+				size_t w = from / 64;
+				if (w >= nwords_)
+					return npos;
+				uint64_t bits = words_[w].load(std::memory_order_acquire) & (~uint64_t(0) << (from % 64));
+				while (!bits) {
+					if (++w == nwords_)
+						return npos;
+					bits = words_[w].load(std::memory_order_acquire);
+				}
+				const size_t bit = lowest_bit_(bits);
+				clear_bit_(w, uint64_t(1) << bit);
+				return w * 64 + bit;
+			}
+
+			bool empty() const
+			{
+				for (size_t w = 0; w < nwords_; ++w)
+					if (words_[w].load(std::memory_order_acquire))
+						return false;
+				return true;
+			}
+
+			// shared lists:  wait until a bit is set, wake() is called, or timeout
+			void park(std::chrono::nanoseconds timeout)
+			{
+				std::unique_lock<std::mutex> lock(park_mutex_);
+				parked_.store(true, std::memory_order_seq_cst);
+				if (empty())
+					park_cv_.wait_for(lock, timeout);
+				parked_.store(false, std::memory_order_relaxed);
+			}
+
+			bool parked() const { return parked_.load(std::memory_order_acquire); }
+
+			void wake()
+			{
+				std::lock_guard<std::mutex> lock(park_mutex_);
+				park_cv_.notify_all();
+			}
+		};
+
 		template<typename COUNTER_TYPE>class semaphore_t: public traceable<semaphore_t<COUNTER_TYPE>>
 		{
 
@@ -18,33 +149,70 @@ namespace sel {
 			void set_rate(rate_t new_rate) { rate_ = new_rate;  }
 			void set_rate(size_t numer, size_t denom) { rate_ = rate_t(numer, denom);  }
 
-			COUNTER_TYPE count() const { return _count;  }
+			COUNTER_TYPE count() const { return _count.load(std::memory_order_acquire);  }
 
 			mutable bool enabled = true;
 
 		private:
 
-			mutable COUNTER_TYPE _count;
+			mutable std::atomic<COUNTER_TYPE> _count;
 			rate_measure<COUNTER_TYPE> rate_;
 
+			// the ready list of the scheduler running this semaphore's schedule, and the schedule's slot in it
+			std::shared_ptr<ready_list> ready_list_;
+			size_t ready_slot_ = 0;
+			// attached to a shared list:  other threads may raise the semaphore, while its schedule's thread acquires it
+			bool shared_ = false;
+
+			void add_(COUNTER_TYPE n) const
+			{
+				if (shared_)
+					_count.fetch_add(n, std::memory_order_acq_rel);
+				else
+					_count.store(_count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+			}
+
+			void sub_(COUNTER_TYPE n) const
+			{
+				if (shared_)
+					_count.fetch_sub(n, std::memory_order_acq_rel);
+				else
+					_count.store(_count.load(std::memory_order_relaxed) - n, std::memory_order_relaxed);
+			}
+
 		public:
 
 			std::ostream& trace(std::ostream& os) const override
 			{
-				os << _count; //rate_.iters();
+				os << count(); //rate_.iters();
 				return os;
 			}
 
 
 			rate_measure<COUNTER_TYPE>& rate() { return rate_; }
 
+			// Only the thread running the semaphore's schedule acquires it.  If shared, other threads may raise it meanwhile.
 			size_t acquire() const
 			{
-				if (_count && enabled) {
+				const COUNTER_TYPE count = this->count();
+				if (count && enabled) {
 
 					rate_.iterate(); // iterate the rate measurement when semaphore is acquired
+					sub_(1);
+					return count;
+				}
+				return 0;
+			}
 
-					return _count--;
+			// acquire up to max_count at once, for block processing.  Returns the number acquired
+			size_t acquire(size_t max_count) const
+			{
+				const COUNTER_TYPE count = this->count();
+				if (count && enabled) {
+					const size_t n = std::min<size_t>(count, max_count);
+					rate_.iterate(n);
+					sub_(n);
+					return n;
 				}
 				return 0;
 			}
@@ -58,16 +226,30 @@ namespace sel {
 
 			void raise(size_t semaphore_count = 1) const
 			{
-				_count += semaphore_count;
+				add_(semaphore_count);
+				if (ready_list_)
+					ready_list_->set(ready_slot_);
+			}
+
+			bool pending() const { return count() != 0; }
+
+			// called by the scheduler when it adds this semaphore's schedule, or gives the schedule to a worker thread.
+			// Not while the semaphore is being raised.
+			void attach(std::shared_ptr<ready_list> list, size_t slot)
+			{
+				ready_list_ = std::move(list);
+				ready_slot_ = slot;
+				shared_ = ready_list_ && ready_list_->shared();
+				if (ready_list_ && pending())
+					ready_list_->set(ready_slot_);
 			}
 			void reset() const
 			{
-				_count = 0;
+				_count.store(0, std::memory_order_release);
 			}
 		};
-		// For multi-threaded
-		// typedef semaphore_t<std::atomic_size_t> semaphore;
-		// For single-threaded
+		// A semaphore's count is atomic, but is only updated with atomic read-modify-writes if the semaphore is shared
+		// between threads (by a multi-threaded scheduler).  Otherwise plain loads and stores are used.
 		typedef semaphore_t<std::size_t> semaphore;
 
 
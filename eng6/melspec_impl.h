@@ -3,11 +3,20 @@
 #include <cmath>
 #include <vector>
 #include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <algorithm>
+#include <type_traits>
+#include <eigen3/Eigen/Dense>
 #include "../eng6/array2d.h"
 #include "../eng6/numpy.h"
+#include "../eng6/procs/simd.h"
 /**
 	MEL spectrum implementation, derived from librosa's implementation.
 	Given an fft magnitude spectrum, it produces a mel-scaled spectrum.
+	For offline use, apply_block() projects a block of K spectra with matrix-matrix products (Eigen).
 	
 	Author: Josh Greifer
 	Date:	20 Oct 2020
@@ -23,40 +32,99 @@
 	This is gives the same results as
 	mel_filterbank = librosa.filters.mel(16000, 512, n_mels=80, fmin=0, fmax=8000, htk=True)
 	mel = mel_filterbank.dot(fft_mag)
+
+	The filter bank itself is a mel_filterbank, which is immutable and shared (through mel_filterbank_cache)
+	by every melspec_impl with the same settings, so creating a melspec_impl is just a cache lookup.
 */
 
-template<class T, unsigned int sr, unsigned int nMels, unsigned int nFft, bool Htk=true, class internal_T=double>class melspec_impl
+enum class mel_norm { none, slaney };
+
+// Triangular mel filter bank, as librosa.filters.mel(sr, n_fft, n_mels, fmin, fmax, htk, norm).
+// Immutable once constructed.
+template<class internal_T=double>class mel_filterbank
 {
-	static constexpr size_t real_spectrum_length = nFft / 2 + 1;
-	static constexpr internal_T nyquist_frequency = sr / 2.0;
-	static constexpr bool htk = Htk;
+public:
+	// Each triangular filter is nonzero over only a few bins.  apply() uses just that span:
+	// band i covers bins start_bin .. start_bin+length-1, with weights band_weights_[offset .. offset+length-1]
+	struct band_t { size_t start_bin; size_t length; size_t offset; };
+
+	const double sr;
+	const size_t n_fft;
+	const size_t n_mels;
+	const double fmin;
+	const double fmax;
+	const bool htk;
+	const mel_norm norm;
+	const size_t n_bins;	// n_fft / 2 + 1
 
-	using weights_t = sel::array2d<internal_T, nMels,real_spectrum_length>;
-    mutable weights_t *weights_;
-    weights_t& weights;
+private:
+	// For apply_block(): groups of panel_bands adjacent filters, each with the weights over the union of their spans,
+	// as a length x n_bands matrix.  Multiplying a K x length block of spectra by it gives n_bands mel values of K frames.
+	// (A single product with the dense weights would be mostly multiplications by zero.)
+	static constexpr size_t panel_bands = 8;
+	using panel_matrix_t = Eigen::Matrix<internal_T, Eigen::Dynamic, Eigen::Dynamic>;
+	struct panel_t { size_t first_band; size_t n_bands; size_t start_bin; size_t length; panel_matrix_t weights; };
 
+	// dense, n_mels x n_bins, row major
+	std::vector<internal_T> weights_;
+	std::vector<band_t> bands_;
+	std::vector<internal_T> band_weights_;
+	std::vector<panel_t> panels_;
 
-	std::vector<internal_T> calc_mel_frequencies(size_t n_mels = nMels + 2, internal_T fmin = 0, internal_T fmax = nyquist_frequency)
+	std::vector<internal_T> calc_mel_frequencies() const
 	{
-		auto min_mel = frequency_to_mel_(fmin);
-		auto max_mel = frequency_to_mel_(fmax);
-		auto mels = sel::numpy::linspace<internal_T, internal_T>(min_mel, max_mel, n_mels);
-		std::transform(mels.begin(), mels.end(), mels.begin(), [](auto v) { return mel_to_frequency(v);  });
+		auto min_mel = frequency_to_mel(fmin, htk);
+		auto max_mel = frequency_to_mel(fmax, htk);
+		auto mels = sel::numpy::linspace<internal_T, internal_T>(min_mel, max_mel, n_mels + 2);
+		std::transform(mels.begin(), mels.end(), mels.begin(), [this](auto v) { return mel_to_frequency(v, htk);  });
 		return mels;
 	}
 
-	
-public:
-   // std::move(*std::make_unique<T>()
-    using Ptr = std::shared_ptr<const melspec_impl>;
+	void calc_bands_()
+	{
+		for (size_t i = 0; i < n_mels; ++i)
+		{
+			const internal_T *row = weights_.data() + i * n_bins;
+			size_t first = 0;
+			while (first < n_bins && row[first] == 0)
+				++first;
+			size_t last = n_bins;
+			while (last > first && row[last - 1] == 0)
+				--last;
+			bands_.push_back({ first, last - first, band_weights_.size() });
+			band_weights_.insert(band_weights_.end(), row + first, row + last);
+		}
+	}
 
-	melspec_impl() : weights_(new weights_t), weights(*weights_)
+	void calc_panels_()
+	{
+		for (size_t first_band = 0; first_band < n_mels; first_band += panel_bands)
+		{
+			const size_t nbands = std::min(panel_bands, n_mels - first_band);
+			size_t start = n_bins, end = 0;
+			for (size_t i = first_band; i < first_band + nbands; ++i)
+				if (bands_[i].length) {
+					start = std::min(start, bands_[i].start_bin);
+					end = std::max(end, bands_[i].start_bin + bands_[i].length);
+				}
+			if (end < start)
+				start = end = 0;
+			panel_matrix_t w(end - start, nbands);
+			for (size_t i = 0; i < nbands; ++i)
+				for (size_t j = start; j < end; ++j)
+					w(j - start, i) = weights_[(first_band + i) * n_bins + j];
+			panels_.push_back({ first_band, nbands, start, end - start, std::move(w) });
+		}
+	}
+
+public:
+	mel_filterbank(double sr, size_t n_fft, size_t n_mels, double fmin, double fmax, bool htk, mel_norm norm) :
+		sr(sr), n_fft(n_fft), n_mels(n_mels), fmin(fmin), fmax(fmax), htk(htk), norm(norm), n_bins(n_fft / 2 + 1),
+		weights_(n_mels * n_bins)
 	{
-		
 		auto mel_f = calc_mel_frequencies();
-		auto fft_freqencies = sel::numpy::linspace<internal_T, internal_T>(0.0, sr / 2.0, real_spectrum_length);
-		// auto fdiff = sel::numpy::diff(mel_f);
-		for (size_t i = 0; i < nMels; ++i)
+		auto fft_freqencies = sel::numpy::linspace<internal_T, internal_T>(0.0, sr / 2.0, n_bins);
+		for (size_t i = 0; i < n_mels; ++i)
 		{
 			auto m0 = mel_f[i];
 			auto m1 = mel_f[i + 1];
@@ -64,98 +132,212 @@ public:
 			auto fdiff = m1 - m0;
 			auto fdiff_1 = m2 - m1;
 			auto enorm = 2.0 / (m2 - m0);
-			for (size_t j = 0; j < real_spectrum_length; ++j)
+			for (size_t j = 0; j < n_bins; ++j)
 			{
 				const auto f = fft_freqencies[j];
 				const auto ramp_i = m0 - f;
 				const auto lower = -ramp_i / fdiff;
-				
+
 				const auto ramp_i_plus_2 = m2 - f;
 
 				const auto upper = ramp_i_plus_2 / fdiff_1;
-				auto w = std::max(0.0, std::min(lower, upper));
+				internal_T w = std::max<internal_T>(0, std::min(lower, upper));
 				// Slaney normalization
-				w *= enorm;
-                weights(i, j) = w;
+				if (norm == mel_norm::slaney)
+					w *= enorm;
+				weights_[i * n_bins + j] = w;
 			}
 		}
-		//calculate_mel_filter_bank_();
+		calc_bands_();
+		calc_panels_();
 	}
 
-	~melspec_impl()
+	mel_filterbank(const mel_filterbank&) = delete;
+	mel_filterbank& operator=(const mel_filterbank&) = delete;
+
+	// magnitude (or power) spectrum, n_bins values, to n_mels mel values
+	template<class T>void apply(const T* inputMagnitudeSpectrum, T *outputMelFrequencySpectrum) const
 	{
-		delete weights_;
+		apply_bands_(n_mels, inputMagnitudeSpectrum, outputMelFrequencySpectrum);
 	}
 
-	void fft_mag2mel(const T* inputMagnitudeSpectrum, T *outputMelFrequencySpectrum)
+	// K spectra to K mel spectra.  Spectrum k is at spectra + k * spectrum_stride (at least n_bins values),
+	// its mel spectrum is written to mel + k * n_mels.
+	template<class T>void apply_block(const T* spectra, size_t spectrum_stride, T *mel, size_t K) const
+	{
+		if constexpr (std::is_same_v<T, internal_T>) {
+			using block_t = Eigen::Matrix<internal_T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+			using stride_t = Eigen::OuterStride<>;
+			Eigen::Map<block_t, 0, stride_t> M(mel, K, n_mels, stride_t(n_mels));
+			for (const auto& panel : panels_) {
+				Eigen::Map<const block_t, 0, stride_t> S(spectra + panel.start_bin, K, panel.length, stride_t(spectrum_stride));
+				M.middleCols(panel.first_band, panel.n_bands).noalias() = S * panel.weights;
+			}
+		}
+		else
+			for (size_t k = 0; k < K; ++k)
+				apply(spectra + k * spectrum_stride, mel + k * n_mels);
+	}
 
+	// as apply(), for a filter bank known at compile time to have NMELS bands (used by melspec_impl)
+	template<size_t NMELS, class T>void apply_fixed(const T* inputMagnitudeSpectrum, T *outputMelFrequencySpectrum) const
+	{
+		apply_bands_(NMELS, inputMagnitudeSpectrum, outputMelFrequencySpectrum);
+	}
+
+private:
+	template<class T>inline void apply_bands_(const size_t nbands, const T* inputMagnitudeSpectrum, T *outputMelFrequencySpectrum) const
 	{
-		for (int i = 0; i < nMels; ++i)
+		for (size_t i = 0; i < nbands; ++i)
 		{
+			const auto& band = bands_[i];
+			const T *x = inputMagnitudeSpectrum + band.start_bin;
+			const internal_T *w = band_weights_.data() + band.offset;
 			internal_T coeff = 0;
 
-			for (size_t j = 0; j < real_spectrum_length; ++j)
-				coeff += inputMagnitudeSpectrum[j] * weights(i,j);
+			if constexpr (std::is_same_v<T, internal_T>)
+				coeff = simd::dot(x, w, static_cast<unsigned>(band.length));
+			else
+				for (size_t j = 0; j < band.length; ++j)
+					coeff += x[j] * w[j];
 
 			outputMelFrequencySpectrum[i] = static_cast<T>(coeff);
 		}
-
 	}
 
-	const auto& filterBank() const {
-		return weights;
-	}
-private:
+public:
 
+	const std::vector<internal_T>& weights() const { return weights_; }
+	const band_t& band(size_t i) const { return bands_[i]; }
+	const internal_T *band_weights(size_t i) const { return band_weights_.data() + bands_[i].offset; }
 
-	
-//	internal_T& weights(size_t coeff, size_t specbin) const
-//	{
-//		return (*weights_)[coeff * real_spectrum_length + specbin];
-//	}
-   static internal_T frequency_to_mel_(internal_T frequency)
-   {
-	    if constexpr (htk) {
-            return 2595.0 * log10(1.0 + frequency / 700.0);
-	    } else {
+	static internal_T frequency_to_mel(internal_T frequency, bool htk)
+	{
+		if (htk) {
+			return 2595.0 * log10(1.0 + frequency / 700.0);
+		} else {
 // Fill in the linear part
-            auto f_min = 0.0;
-            auto f_sp = 200.0 / 3;
+			auto f_min = 0.0;
+			auto f_sp = 200.0 / 3;
 
-            auto mel = (frequency - f_min) / f_sp;
+			auto mel = (frequency - f_min) / f_sp;
 
 // Fill in the log-scale part
 
-            auto min_log_hz = 1000.0;  // beginning of log region (Hz)
-            auto min_log_mel = (min_log_hz - f_min) / f_sp;  // same (Mels)
-            auto log_step = std::log(6.4) / 27.0;  //step size for log region
-
-            if (frequency >= min_log_hz)
-                return  min_log_mel + std::log(frequency / min_log_hz) / log_step;
-            return mel;
+			auto min_log_hz = 1000.0;  // beginning of log region (Hz)
+			auto min_log_mel = (min_log_hz - f_min) / f_sp;  // same (Mels)
+			auto log_step = std::log(6.4) / 27.0;  //step size for log region
 
-	    }
-   }
+			if (frequency >= min_log_hz)
+				return  min_log_mel + std::log(frequency / min_log_hz) / log_step;
+			return mel;
 
+		}
+	}
 
-    static internal_T mel_to_frequency(internal_T mel) {
-        if constexpr (htk) {
-            return 700.0 * (pow(10.0, mel / 2595.0) - 1.0);
-        } else {
-            // Fill in the linear scale
-            auto f_min = 0.0;
-            auto f_sp = 200.0 / 3;
-            auto freq = f_min + f_sp * mel;
+	static internal_T mel_to_frequency(internal_T mel, bool htk) {
+		if (htk) {
+			return 700.0 * (pow(10.0, mel / 2595.0) - 1.0);
+		} else {
+			// Fill in the linear scale
+			auto f_min = 0.0;
+			auto f_sp = 200.0 / 3;
+			auto freq = f_min + f_sp * mel;
 
 // And now the nonlinear scale
-            auto min_log_hz = 1000.0; // beginning of log region (Hz)
-            auto min_log_mel = (min_log_hz - f_min) / f_sp; //same (Mels)
-            auto log_step = std::log(6.4) / 27.0;  // step size for log region
-            if (mel >= min_log_mel)
-                return min_log_hz * std::exp(log_step * (mel - min_log_mel));
-            return freq;
+			auto min_log_hz = 1000.0; // beginning of log region (Hz)
+			auto min_log_mel = (min_log_hz - f_min) / f_sp; //same (Mels)
+			auto log_step = std::log(6.4) / 27.0;  // step size for log region
+			if (mel >= min_log_mel)
+				return min_log_hz * std::exp(log_step * (mel - min_log_mel));
+			return freq;
 
-        }
+		}
+	}
+};
+
+// Process-wide cache of mel filter banks, keyed by all their settings.
+// Holds weak references: a filter bank lives as long as some melspec uses it, and is rebuilt if requested again after that.
+template<class internal_T=double>class mel_filterbank_cache
+{
+	// (sr, n_fft, n_mels, fmin, fmax, htk, norm)
+	using key = std::tuple<double, size_t, size_t, double, double, bool, mel_norm>;
+
+	std::mutex mutex_;
+	std::map<key, std::weak_ptr<const mel_filterbank<internal_T>>> banks_;
+
+	mel_filterbank_cache() = default;
+
+public:
+	mel_filterbank_cache(const mel_filterbank_cache&) = delete;
+	mel_filterbank_cache& operator=(const mel_filterbank_cache&) = delete;
+
+	static mel_filterbank_cache& get()
+	{
+		static mel_filterbank_cache instance;
+		return instance;
+	}
+
+	// Returns the shared filter bank for these settings, building it if no-one holds it
+	std::shared_ptr<const mel_filterbank<internal_T>> filterbank(double sr, size_t n_fft, size_t n_mels, double fmin, double fmax, bool htk, mel_norm norm)
+	{
+		const key k{ sr, n_fft, n_mels, fmin, fmax, htk, norm };
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto& entry = banks_[k];
+		auto bank = entry.lock();
+		if (!bank) {
+			bank = std::make_shared<const mel_filterbank<internal_T>>(sr, n_fft, n_mels, fmin, fmax, htk, norm);
+			entry = bank;
+		}
+		return bank;
+	}
+
+	// number of filter banks currently in use
+	size_t size()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		size_t n = 0;
+		for (auto& [k, bank] : banks_)
+			n += !bank.expired();
+		return n;
+	}
+};
+
+template<class T, unsigned int sr, unsigned int nMels, unsigned int nFft, bool Htk=true, class internal_T=double>class melspec_impl
+{
+	static constexpr size_t real_spectrum_length = nFft / 2 + 1;
+	static constexpr internal_T nyquist_frequency = sr / 2.0;
+	static constexpr bool htk = Htk;
+
+	std::shared_ptr<const mel_filterbank<internal_T>> filterbank_;
+
+public:
+   // std::move(*std::make_unique<T>()
+    using Ptr = std::shared_ptr<const melspec_impl>;
+
+	melspec_impl() :
+		filterbank_(mel_filterbank_cache<internal_T>::get().filterbank(sr, nFft, nMels, 0, nyquist_frequency, htk, mel_norm::slaney))
+	{
 	}
 
-};
\ No newline at end of file
+	void fft_mag2mel(const T* inputMagnitudeSpectrum, T *outputMelFrequencySpectrum) const
+	{
+		filterbank_->template apply_fixed<nMels>(inputMagnitudeSpectrum, outputMelFrequencySpectrum);
+	}
+
+	// K spectra, spectrum k at inputMagnitudeSpectra + k * stride, to K consecutive mel spectra
+	void fft_mag2mel_block(const T* inputMagnitudeSpectra, size_t stride, T *outputMelFrequencySpectra, size_t K) const
+	{
+		filterbank_->apply_block(inputMagnitudeSpectra, stride, outputMelFrequencySpectra, K);
+	}
+
+	// dense filter bank, nMels x (nFft/2+1), row major
+	const auto& filterBank() const {
+		return filterbank_->weights();
+	}
+
+	const mel_filterbank<internal_T>& filterbank() const {
+		return *filterbank_;
+	}
+};
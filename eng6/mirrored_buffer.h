@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace sel {
+	/*
+	Ring buffer storage whose pages are mapped twice, back to back:  bytes() of memory, visible at data() and again
+	at data() + bytes().  So a span of up to bytes() starting anywhere in the first copy is contiguous, and writing
+	it writes the ring, with no mirroring or wrap-around copies in software.
+
+	Linux only (memfd + two fixed mmaps of it).  bytes must be a multiple of the page size.
+	Elsewhere, or if the mapping fails, the constructor throws;  quick_queue then keeps its own double-sized buffer.
+	*/
+	class mirrored_buffer
+	{
+		char *base_ = nullptr;
+		size_t bytes_ = 0;
+
+	public:
+		static size_t page_size()
+		{
+#if defined(__linux__)
+			return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+			return 0;
+#endif
+		}
+
+		static bool supported(size_t bytes)
+		{
+			const auto page = page_size();
+			return page && bytes && bytes % page == 0;
+		}
+
+		mirrored_buffer() = default;
+
+		explicit mirrored_buffer(size_t bytes)
+		{
+			if (!supported(bytes))
+				throw std::runtime_error("mirrored_buffer: size must be a nonzero multiple of the page size");
+#if defined(__linux__)
+			const int fd = static_cast<int>(syscall(SYS_memfd_create, "sel_mirrored_buffer", 0));
+			if (fd < 0)
+				throw std::runtime_error("mirrored_buffer: memfd_create failed");
+			if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+				close(fd);
+				throw std::runtime_error("mirrored_buffer: ftruncate failed");
+			}
+			// reserve the address range for both copies, then map the file over each half
+			void *base = mmap(nullptr, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (base == MAP_FAILED) {
+				close(fd);
+				throw std::runtime_error("mirrored_buffer: mmap failed");
+			}
+			char *p = static_cast<char *>(base);
+			const bool mapped =
+				mmap(p, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED &&
+				mmap(p + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+			close(fd);
+			if (!mapped) {
+				munmap(base, 2 * bytes);
+				throw std::runtime_error("mirrored_buffer: mmap failed");
+			}
+			base_ = p;
+			bytes_ = bytes;
+#endif
+		}
+
+		~mirrored_buffer()
+		{
+#if defined(__linux__)
+			if (base_)
+				munmap(base_, 2 * bytes_);
+#endif
+		}
+
+		mirrored_buffer(const mirrored_buffer&) = delete;
+		mirrored_buffer& operator=(const mirrored_buffer&) = delete;
+
+		mirrored_buffer(mirrored_buffer&& other) noexcept :
+			base_(std::exchange(other.base_, nullptr)), bytes_(std::exchange(other.bytes_, 0)) {}
+
+		mirrored_buffer& operator=(mirrored_buffer&& other) noexcept
+		{
+			std::swap(base_, other.base_);
+			std::swap(bytes_, other.bytes_);
+			return *this;
+		}
+
+		void *data() const { return base_; }
+		size_t bytes() const { return bytes_; }
+		explicit operator bool() const { return base_ != nullptr; }
+	};
+} // sel
@@ -0,0 +1,159 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+namespace sel {
+	/*
+	Bounded lock-free multi-producer / multi-consumer queue of fixed-size frames (W elements each),
+	for fanning processed frames in from several threads to one (or more) consumers.
+	Any number of threads may call the producer functions, and any number the consumer functions.  No mutex is used.
+
+	producer:	try_put(frame), put(frame)		(put() throws if the queue is full)
+	consumer:	try_get(frame), get(frame)		(get() throws if the queue is empty)
+
+	The algorithm is Dmitry Vyukov's bounded MPMC queue.  Each slot holds a frame and a sequence number, which says
+	whose turn it is:  a slot at position pos may be written when its sequence is pos, and read when it is pos + 1.
+	A producer claims a position with a CAS on enqueue_pos_, writes the frame, then publishes it by storing pos + 1
+	in the slot's sequence (release).  A consumer claims with a CAS on dequeue_pos_, reads, then hands the slot back to
+	the producers of the next lap by storing pos + capacity.  Threads only contend on the two positions;  each slot
+	and each position has a cache line to itself.
+
+	Frames from any one producer thread are read in the order that thread wrote them.
+	capacity (in frames) must be a power of two.
+	*/
+	template<typename T, const size_t W = 1>class mpmc_queue
+	{
+		static_assert(W > 0, "mpmc_queue: frame width W must be nonzero");
+		static_assert(std::is_default_constructible<T>::value, "mpmc_queue: T must be default constructible");
+
+		static constexpr size_t cache_line = 64;
+
+		struct alignas(cache_line) slot_t
+		{
+			std::atomic<size_t> seq;
+			std::array<T, W> frame;
+		};
+
+		const size_t capacity_;
+		const size_t mask_;
+		std::unique_ptr<slot_t[]> slots_;
+
+		alignas(cache_line) std::atomic<size_t> enqueue_pos_{ 0 };
+		alignas(cache_line) std::atomic<size_t> dequeue_pos_{ 0 };
+		alignas(cache_line) char pad_[cache_line] = {};
+
+		static void copy_(const T *from, T *to)
+		{
+			if constexpr (std::is_trivially_copyable<T>::value)
+				std::memcpy(to, from, W * sizeof(T));
+			else
+				std::copy(from, from + W, to);
+		}
+
+		static size_t check_capacity_(size_t capacity)
+		{
+			if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+				throw std::runtime_error("mpmc_queue: capacity must be a power of two, and at least 2");
+			return capacity;
+		}
+
+	public:
+		static constexpr size_t width = W;
+
+		explicit mpmc_queue(size_t capacity) :
+			capacity_(check_capacity_(capacity)),
+			mask_(capacity - 1),
+			slots_(new slot_t[capacity])
+		{
+			for (size_t i = 0; i < capacity_; ++i)
+				slots_[i].seq.store(i, std::memory_order_relaxed);
+		}
+
+		mpmc_queue(const mpmc_queue&) = delete;
+		mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+		// capacity, in frames
+		size_t size() const { return capacity_; }
+
+		// approximate number of frames queued, when other threads are using the queue
+		size_t get_avail() const
+		{
+			const size_t tail = dequeue_pos_.load(std::memory_order_acquire);
+			const size_t head = enqueue_pos_.load(std::memory_order_acquire);
+			return head > tail ? std::min(head - tail, capacity_) : 0;
+		}
+		size_t put_avail() const { return capacity_ - get_avail(); }
+		bool isempty() const { return get_avail() == 0; }
+		bool isfull() const { return get_avail() == capacity_; }
+
+		////// producers
+
+		// copy a frame of W elements in, or return false if the queue is full
+		bool try_put(const T *frame)
+		{
+			slot_t *slot;
+			size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+			for (;;) {
+				slot = &slots_[pos & mask_];
+				const size_t seq = slot->seq.load(std::memory_order_acquire);
+				const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+				if (diff == 0) {
+					if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				} else if (diff < 0)
+					return false;	// the slot still holds last lap's frame:  full
+				else
+					pos = enqueue_pos_.load(std::memory_order_relaxed);
+			}
+			copy_(frame, slot->frame.data());
+			slot->seq.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		void put(const T *frame)
+		{
+			if (!try_put(frame))
+				throw std::runtime_error("mpmc_queue::put: buffer is full");
+		}
+
+		////// consumers
+
+		// copy a frame of W elements out, or return false if the queue is empty
+		bool try_get(T *frame)
+		{
+			slot_t *slot;
+			size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+			for (;;) {
+				slot = &slots_[pos & mask_];
+				const size_t seq = slot->seq.load(std::memory_order_acquire);
+				const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+				if (diff == 0) {
+					if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				} else if (diff < 0)
+					return false;	// not yet written:  empty
+				else
+					pos = dequeue_pos_.load(std::memory_order_relaxed);
+			}
+			copy_(slot->frame.data(), frame);
+			slot->seq.store(pos + capacity_, std::memory_order_release);
+			return true;
+		}
+
+		void get(T *frame)
+		{
+			if (!try_get(frame))
+				throw std::runtime_error("mpmc_queue::get: buffer is empty");
+		}
+	};
+
+} // sel
+#if defined(COMPILE_UNIT_TESTS)
+#include "mpmc_queue_ut.h"
+#endif
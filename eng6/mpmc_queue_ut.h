@@ -0,0 +1,111 @@
+#pragma once
+
+// multi-producer / multi-consumer queue unit test
+#include "mpmc_queue.h"
+#include <thread>
+#include <vector>
+#include "unit_test.h"
+SEL_UNIT_TEST(mpmc_queue)
+
+struct ut_traits
+{
+	static constexpr size_t frame_width = 4;
+	static constexpr size_t producers = 4;
+	static constexpr size_t consumers = 3;
+	static constexpr size_t frames_per_producer = 100000;
+	static constexpr size_t queue_size = 64;
+};
+
+using frame_queue = sel::mpmc_queue<uint64_t, ut_traits::frame_width>;
+
+// frame n of producer p is { p, n, p ^ n, p + n }:  a torn frame fails the check
+static void make_frame(uint64_t p, uint64_t n, uint64_t *frame)
+{
+	frame[0] = p; frame[1] = n; frame[2] = p ^ n; frame[3] = p + n;
+}
+
+static bool frame_ok(const uint64_t *frame)
+{
+	return frame[0] < ut_traits::producers && frame[2] == (frame[0] ^ frame[1]) && frame[3] == frame[0] + frame[1];
+}
+
+void run()
+{
+	SEL_UNIT_TEST_ITEM("single thread");
+	{
+		bool threw_exception = false;
+		try {
+			frame_queue bad(24);
+		}
+		catch (std::runtime_error&) {
+			threw_exception = true;
+		}
+		SEL_UNIT_TEST_ASSERT(threw_exception);
+
+		frame_queue q(4);
+		uint64_t frame[ut_traits::frame_width];
+		SEL_UNIT_TEST_ASSERT(q.isempty() && !q.try_get(frame));
+		for (uint64_t n = 0; n < 4; ++n) {
+			make_frame(1, n, frame);
+			SEL_UNIT_TEST_ASSERT(q.try_put(frame));
+		}
+		SEL_UNIT_TEST_ASSERT(q.isfull() && !q.try_put(frame));
+		// several laps round the ring
+		for (uint64_t n = 0; n < 10; ++n) {
+			q.get(frame);
+			SEL_UNIT_TEST_ASSERT(frame_ok(frame) && frame[1] == n);
+			make_frame(1, n + 4, frame);
+			q.put(frame);
+		}
+		SEL_UNIT_TEST_ASSERT(q.get_avail() == 4);
+	}
+
+	// every frame arrives exactly once, whole, and each consumer sees each producer's frames in order
+	SEL_UNIT_TEST_ITEM("many producers, many consumers");
+	{
+		frame_queue q(ut_traits::queue_size);
+		std::atomic<size_t> received{ 0 };
+		std::vector<std::atomic<uint64_t>> seen(ut_traits::producers * ut_traits::frames_per_producer);
+		std::atomic<size_t> errors{ 0 };
+
+		std::vector<std::thread> threads;
+		for (size_t p = 0; p < ut_traits::producers; ++p)
+			threads.emplace_back([&q, p] {
+				uint64_t frame[ut_traits::frame_width];
+				for (uint64_t n = 0; n < ut_traits::frames_per_producer; ++n) {
+					make_frame(p, n, frame);
+					while (!q.try_put(frame))
+						std::this_thread::yield();
+				}
+			});
+		for (size_t c = 0; c < ut_traits::consumers; ++c)
+			threads.emplace_back([&] {
+				uint64_t frame[ut_traits::frame_width];
+				std::vector<int64_t> last(ut_traits::producers, -1);
+				const size_t total = ut_traits::producers * ut_traits::frames_per_producer;
+				while (received.load() < total) {
+					if (!q.try_get(frame)) {
+						std::this_thread::yield();
+						continue;
+					}
+					++received;
+					if (!frame_ok(frame) || frame[1] >= ut_traits::frames_per_producer) {
+						++errors;
+						continue;
+					}
+					const auto p = frame[0], n = frame[1];
+					errors += static_cast<int64_t>(n) <= last[p];
+					last[p] = static_cast<int64_t>(n);
+					errors += seen[p * ut_traits::frames_per_producer + n]++ != 0;
+				}
+			});
+		for (auto& t : threads)
+			t.join();
+
+		SEL_UNIT_TEST_ASSERT(errors == 0);
+		SEL_UNIT_TEST_ASSERT(received == ut_traits::producers * ut_traits::frames_per_producer);
+		SEL_UNIT_TEST_ASSERT(q.isempty());
+	}
+}
+
+SEL_UNIT_TEST_END
@@ -23,6 +23,9 @@ namespace sel {
 
 			void operator()() final { process(); }
 			virtual void process() = 0;
+			// Process n ticks in one call.  Processors that opt in to block processing (see ConnectableProcessor) override this
+			// to work through n frames of each port in a loop;  otherwise it is n calls of process()
+			virtual void process_block(size_t n) { for (size_t i = 0; i < n; ++i) process(); }
 			virtual void init(schedule *context) {};
 			virtual void term(schedule *context) {};
 
@@ -36,6 +39,28 @@ namespace sel {
 			virtual ConnectableProcessor& input_proc()  { return *this; }
 			virtual ConnectableProcessor& output_proc() { return *this; }
 
+			/*
+			Block processing (opt in).
+			A processor returning true from block_capable() implements process_block(n) for any n up to the number of
+			frames its ports hold, reading frame k of each input at in + k * input width, and writing frame k of each
+			output likewise.  Before freeze(), the schedule calls set_block_frames() to size the output ports for its
+			largest block.  A schedule only runs blocks if its action is block capable, and every input port it reads
+			holds that many frames (block_ready());  otherwise it runs process() once per tick, as before.
+			*/
+			virtual bool block_capable() const { return false; }
+			virtual void set_block_frames(size_t n)
+			{
+				for (auto port : outports)
+					port->setframes(n);
+			}
+			virtual bool block_ready(size_t n) const
+			{
+				for (auto port : inports)
+					if (!port || port->frames() < n)
+						return false;
+				return true;
+			}
+
 			virtual std::ostream& trace(std::ostream& os) const override
 			{
 				return Connectable::trace(os);
@@ -279,7 +304,8 @@ namespace sel {
 				Connectable::freeze();
 
 				// Once widths are set,  we can directly access underlying data, as it will not be moved any more
-
+				// (set_block_frames() may have moved it since construction)
+				out = oport.as_array();
 
 			}
 		};
@@ -2,58 +2,210 @@
 
 #include "../processor.h"
 #include "fft.h"
+#include "simd.h"
 
 namespace sel {
 	namespace eng6 {
 		namespace proc {
-			template<typename traits=eng_traits<> >struct ac : public  Processor1A1B<2 * traits::input_frame_size, traits::input_frame_size>, virtual public creatable<ac<traits> >
+
+			// Autocorrelation of a frame of SZ real samples, lags 0..LAGS-1:
+			//   out[k] = 1/SZ * sum(x[n] * x[n+k]), n = 0..SZ-1-k
+			// (the biased estimate, as used by lpc:  connect ac<traits, p+1> to lpc of order p).
+			// The correlation is linear, not circular: the frame is zero-padded to NFFT >= SZ + LAGS - 1.
+			// For a few lags the direct O(SZ * LAGS) sum (vectorized dot products) is cheaper than the real fft and
+			// its inverse, and is used instead.  The input is not modified.
+			template<typename traits=eng_traits<>, size_t LAGS = traits::input_frame_size>struct ac : public  Processor1A1B<traits::input_frame_size, LAGS>, virtual public creatable<ac<traits, LAGS> >
 			{
 				static constexpr size_t SZ = traits::input_frame_size;
+				static_assert(LAGS >= 1 && LAGS <= SZ, "ac: number of lags must be in [1, frame size]");
+
+				static constexpr size_t log2_ceil(size_t n) { size_t b = 0; while ((size_t(1) << b) < n) ++b; return b; }
+
+				static constexpr size_t NFFT_LOG2 = log2_ceil(SZ + LAGS - 1) < 2 ? 2 : log2_ceil(SZ + LAGS - 1);
+				static constexpr size_t NFFT = size_t(1) << NFFT_LOG2;
 
-				using baseProcessor = Processor1A1B<2 * SZ, SZ>;
+				// SZ * LAGS vectorized multiply-adds, against a forward and inverse real fft of NFFT points (crossover measured on AVX2/AVX-512)
+				static constexpr bool direct = SZ * LAGS <= 6 * NFFT * NFFT_LOG2;
+
+				fixed_rfft<NFFT, samp_t> rfft_;
+				// padded frame, then its NFFT/2+1 bins;  and the inverse transform
+				std::vector<samp_t> spectrum_;
+				std::vector<samp_t> acf_;
 
-				ifft<traits> ifft_;
-				// input is an fft
 			public:
+				const std::string type() const final
+				{
+					char buf[100];
+					snprintf(buf, 100, "ac[%zd,%zd]", SZ, LAGS);
+					return buf;
+				}
 
 				void process(void)
 				{
-					csamp_t *fft_as_complex_array = (csamp_t *)this->in;
-					// get mag multiply each point by its complex conjugate (will reduce imag to 0.0 if input is real)
-					for (size_t i = 0; i < SZ; ++i)
-						fft_as_complex_array[i] *= conj(fft_as_complex_array[i]);
+					const samp_t *x = this->in;
+					constexpr samp_t scale = samp_t(1) / SZ;
+
+					if constexpr (direct) {
+						for (size_t k = 0; k < LAGS; ++k)
+							this->out[k] = simd::dot(x, x + k, static_cast<unsigned>(SZ - k)) * scale;
+					}
+					else {
+						samp_t *spectrum = spectrum_.data();
+						std::copy(x, x + SZ, spectrum);
+						std::fill(spectrum + SZ, spectrum + NFFT, samp_t(0));
 
-					ifft_.process();
+						rfft_.fft(spectrum);
 
-					csamp_t *ifft_as_complex_array = (csamp_t *)ifft_.out;
-					// output real values only, normalized
-					for (size_t i = 0; i < SZ; ++i)
-						this->out[i] = ifft_as_complex_array[i].real() / (samp_t)SZ;
+						// power spectrum: multiply each bin by its complex conjugate
+						for (size_t i = 0; i <= NFFT / 2; ++i) {
+							const samp_t re = spectrum[2 * i];
+							const samp_t im = spectrum[2 * i + 1];
+							spectrum[2 * i] = re * re + im * im;
+							spectrum[2 * i + 1] = 0;
+						}
 
+						rfft_.ifft(spectrum, acf_.data());
+
+						for (size_t k = 0; k < LAGS; ++k)
+							this->out[k] = acf_[k] * scale;
+					}
 				}
+
 				// default constructor needed for factory creation
-				explicit ac() {}
+				explicit ac()
+				{
+					if constexpr (!direct) {
+						spectrum_.resize(NFFT + 2);
+						acf_.resize(NFFT);
+					}
+				}
+
+				ac(params& args) : ac()
+				{
+				}
+			};
+
+			// Autocorrelation from the output of fftr_t (the SZ/2+1 non-redundant bins of a real frame), lags 0..LAGS-1.
+			// Normalized as ac.  The result is the circular autocorrelation of the transformed frame, so it is
+			// only linear if that frame was zero-padded by at least LAGS-1 samples.  The input is not modified.
+			template<typename traits=eng_traits<>, size_t LAGS = traits::input_frame_size>struct ac_spectrum : public  Processor1A1B<2 * (traits::input_frame_size / 2 + 1), LAGS>, virtual public creatable<ac_spectrum<traits, LAGS> >
+			{
+				static constexpr size_t SZ = traits::input_frame_size;
+				static_assert(LAGS >= 1 && LAGS <= SZ, "ac_spectrum: number of lags must be in [1, frame size]");
 
-				void freeze(void) final 
+				fixed_rfft<SZ, samp_t> rfft_;
+				std::vector<samp_t> power_ = std::vector<samp_t>(2 * (SZ / 2 + 1));
+				std::vector<samp_t> acf_ = std::vector<samp_t>(SZ);
+
+			public:
+				const std::string type() const final
 				{
-					ifft_.ConnectInputToInput(*this);
-					ifft_.freeze();
-					baseProcessor::freeze();
+					char buf[100];
+					snprintf(buf, 100, "ac_spectrum[%zd,%zd]", SZ, LAGS);
+					return buf;
 				}
 
-				ac(params& args)
+				void process(void)
 				{
+					for (size_t i = 0; i <= SZ / 2; ++i) {
+						const samp_t re = this->in[2 * i];
+						const samp_t im = this->in[2 * i + 1];
+						power_[2 * i] = re * re + im * im;
+						power_[2 * i + 1] = 0;
+					}
+
+					rfft_.ifft(power_.data(), acf_.data());
+
+					constexpr samp_t scale = samp_t(1) / SZ;
+					for (size_t k = 0; k < LAGS; ++k)
+						this->out[k] = acf_[k] * scale;
 				}
 
+				// default constructor needed for factory creation
+				explicit ac_spectrum() {}
 
+				ac_spectrum(params& args)
+				{
+				}
 			};
 		} // proc
 	} // eng
 } //sel
 #if defined(COMPILE_UNIT_TESTS)
+#include "rand.h"
+#include "lpc.h"
 #include "../unit_test.h"
 
 SEL_UNIT_TEST(ac)
-void run() {}
+
+struct ut_traits
+{
+	static constexpr size_t input_frame_size = 400;
+	static constexpr size_t num_coefficients = 12;
+};
+static constexpr size_t SZ = ut_traits::input_frame_size;
+static constexpr size_t NLAGS = ut_traits::num_coefficients + 1;
+
+void run() {
+	sel::eng6::proc::rand<SZ> rng;
+	sel::eng6::proc::ac<ut_traits> ac_all;			// real fft path
+	sel::eng6::proc::ac<ut_traits, NLAGS> ac_lpc;	// direct path
+	sel::eng6::proc::fftr_t<ut_traits> fftr;
+	sel::eng6::proc::ac_spectrum<ut_traits> ac_spec;
+	sel::eng6::proc::lpc<ut_traits> lpc;
+
+	static_assert(!decltype(ac_all)::direct && decltype(ac_lpc)::direct);
+
+	rng.ConnectTo(ac_all);
+	rng.ConnectTo(ac_lpc);
+	rng.ConnectTo(fftr);
+	fftr.ConnectTo(ac_spec);
+	ac_lpc.ConnectTo(lpc);
+	rng.freeze();
+	ac_all.freeze();
+	ac_lpc.freeze();
+	fftr.freeze();
+	ac_spec.freeze();
+	lpc.freeze();
+
+	rng.process();
+	const std::vector<samp_t> x(rng.out, rng.out + SZ);
+	ac_all.process();
+	ac_lpc.process();
+	fftr.process();
+	std::vector<samp_t> spectrum(fftr.out, fftr.out + 2 * (SZ / 2 + 1));
+	ac_spec.process();
+	lpc.process();
+
+	SEL_UNIT_TEST_ITEM("linear autocorrelation (fft)");
+	for (size_t k = 0; k < SZ; ++k) {
+		samp_t r = 0;
+		for (size_t n = 0; n + k < SZ; ++n)
+			r += x[n] * x[n + k];
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(ac_all.out[k], r / SZ);
+	}
+
+	SEL_UNIT_TEST_ITEM("linear autocorrelation (direct)");
+	for (size_t k = 0; k < NLAGS; ++k)
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(ac_lpc.out[k], ac_all.out[k]);
+
+	SEL_UNIT_TEST_ITEM("circular autocorrelation (spectrum)");
+	for (size_t k = 0; k < SZ; ++k) {
+		samp_t r = 0;
+		for (size_t n = 0; n < SZ; ++n)
+			r += x[n] * x[(n + k) % SZ];
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(ac_spec.out[k], r / SZ);
+	}
+
+	SEL_UNIT_TEST_ITEM("inputs unchanged");
+	for (size_t i = 0; i < SZ; ++i)
+		SEL_UNIT_TEST_ASSERT(rng.out[i] == x[i]);
+	for (size_t i = 0; i < spectrum.size(); ++i)
+		SEL_UNIT_TEST_ASSERT(fftr.out[i] == spectrum[i]);
+
+	// the prediction error filter applied to the frame should leave less energy than the frame itself
+	SEL_UNIT_TEST_ITEM("lpc");
+	SEL_UNIT_TEST_ASSERT(*lpc.e_out > 0 && *lpc.e_out <= ac_lpc.out[0]);
+}
 SEL_UNIT_TEST_END
 #endif
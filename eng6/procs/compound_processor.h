@@ -43,6 +43,32 @@ namespace sel
 					}
 				}
 
+				// a sequence runs in blocks if all its processors can
+				bool block_capable() const override {
+					for (auto proc : *this)
+						if (!proc->block_capable())
+							return false;
+					return !this->empty();
+				}
+
+				void set_block_frames(size_t n) override {
+					for (auto proc : *this)
+						proc->set_block_frames(n);
+				}
+
+				bool block_ready(size_t n) const override {
+					for (auto proc : *this)
+						if (!proc->block_ready(n))
+							return false;
+					return true;
+				}
+
+				void process_block(size_t n) override {
+					for (auto proc : *this) {
+						proc->process_block(n);
+					}
+				}
+
 				void init(schedule *context)  override {
 					for (auto proc : *this) {
 						proc->init(context);
@@ -1,6 +1,7 @@
 #pragma once
 #include "../quick_queue.h"
 #include "../processor.h"
+#include "../scheduler.h"
 #include "../input_stream.h"
 
 namespace sel {
@@ -90,6 +91,11 @@ namespace sel {
 
 		}
 
+		// the buffer is filled by I/O completion handlers, which run on the thread servicing async I/O
+		void init(schedule *context) final {
+			context->set_io_bound();
+		}
+
 		void term(schedule *context) final {
 			istream_->disconnect();
 		}
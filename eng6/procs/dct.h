@@ -1,6 +1,7 @@
 #pragma once
 #include "../processor.h"
 #include "../array2d.h"
+#include "fft_plan.h"
 namespace sel {
     namespace eng6 {
         namespace proc {
@@ -11,9 +12,7 @@ namespace sel {
             // This code uses SciPy's dct definitions, and results match
             // https://docs.scipy.org/doc/scipy/reference/generated/scipy.fftpack.dct.html
 
-            // For fast DCT (not implemented here) see:
-            // https://www.nayuki.io/page/fast-discrete-cosine-transform-algorithms
-            /// TODO: ortho-normalization
+            // For the fast (O(N log N)) DCT, types II and III, see fast_dct below.
 
 
             template<class traits, size_t DctType=2U, size_t SZ = traits::input_frame_size>struct dct : public Processor1A1B<SZ, SZ>, virtual public creatable<dct<traits, DctType, SZ> >
@@ -99,6 +98,114 @@ namespace sel {
                 }
 
             };
+
+            // Fast Discrete Cosine Transform, types II and III, via an N-point real FFT (Makhoul's algorithm):
+            // J. Makhoul, "A fast cosine transform in one and two dimensions", IEEE Trans. ASSP 28(1), 1980.
+            // Results match SciPy's dct (as the naive dct above), or dct(..., norm="ortho") if Ortho.
+            // Type II: the even samples, then the odd samples reversed, are transformed, and bin k is rotated by e^(-i*pi*k/2N).
+            // Type III is the same steps in reverse order.
+            // fast_dct_impl is the bare transform (also used by mfcc), fast_dct is its processor.
+
+            template<size_t SZ, size_t DctType=2U, bool Ortho=false>class fast_dct_impl
+            {
+                static_assert(DctType == 2 || DctType == 3, "fast_dct: only types II and III");
+                static_assert(SZ >= 3, "fast_dct: SZ must be at least 3");
+
+                static constexpr size_t N = SZ;
+
+                fixed_rfft<N, double> rfft_;
+                // the N-point reordered sequence, and its N/2+1 bins
+                std::vector<double> buf_ = std::vector<double>(2 * (N / 2 + 1));
+                std::vector<double> seq_ = std::vector<double>(N);
+                const double *rot_ = rotations();
+
+                // e^(-i*pi*k/2N), k = 0..N-1, interleaved.  Shared by all instances
+                static const double *rotations()
+                {
+                    static const std::vector<double> w = [] {
+                        std::vector<double> w(2 * N);
+                        for (size_t k = 0; k < N; ++k) {
+                            long double s = 0, c = 0;
+                            fft_tables::sincos_2pi(k, 4 * N, s, c);
+                            w[2 * k] = static_cast<double>(c);
+                            w[2 * k + 1] = static_cast<double>(-s);
+                        }
+                        return w;
+                    }();
+                    return w.data();
+                }
+
+            public:
+                // N values in, N out.  in and out must not overlap
+                void transform(const double *in, double *out)
+                {
+                    double *buf = buf_.data();
+                    double *seq = seq_.data();
+
+                    if constexpr (DctType == 2) {
+                        // v[n] = x[2n], v[N-1-n] = x[2n+1]
+                        for (size_t n = 0; 2 * n < N; ++n)
+                            buf[n] = in[2 * n];
+                        for (size_t n = 0; 2 * n + 1 < N; ++n)
+                            buf[N - 1 - n] = in[2 * n + 1];
+
+                        rfft_.fft(buf);
+
+                        // X[k] = 2 Re(W^k V[k]), X[N-k] = -2 Im(W^k V[k])
+                        const double s0 = Ortho ? std::sqrt(1.0 / (4 * N)) : 1.0;
+                        const double s = Ortho ? std::sqrt(1.0 / (2 * N)) : 1.0;
+                        for (size_t k = 0; k <= N / 2; ++k) {
+                            const double vr = buf[2 * k];
+                            const double vi = buf[2 * k + 1];
+                            const double c = rot_[2 * k];
+                            const double si = rot_[2 * k + 1];
+                            out[k] = 2 * (c * vr - si * vi) * (k ? s : s0);
+                            if (k && N - k > N / 2)
+                                out[N - k] = -2 * (c * vi + si * vr) * s;
+                        }
+                    }
+                    else {
+                        // V[k] = N conj(W^k) (X[k] - i X[N-k]), X[N] = 0
+                        const double s0 = Ortho ? std::sqrt(1.0 / N) : 1.0;
+                        const double s = Ortho ? std::sqrt(1.0 / (2 * N)) : 1.0;
+                        for (size_t k = 0; k <= N / 2; ++k) {
+                            const double a = in[k] * (k ? s : s0) * N;
+                            const double b = k ? in[N - k] * s * N : 0.0;
+                            const double c = rot_[2 * k];
+                            const double si = -rot_[2 * k + 1];
+                            buf[2 * k] = a * c + b * si;
+                            buf[2 * k + 1] = a * si - b * c;
+                        }
+
+                        rfft_.ifft(buf, seq);
+
+                        for (size_t n = 0; 2 * n < N; ++n)
+                            out[2 * n] = seq[n];
+                        for (size_t n = 0; 2 * n + 1 < N; ++n)
+                            out[2 * n + 1] = seq[N - 1 - n];
+                    }
+                }
+            };
+
+            template<class traits, size_t DctType=2U, bool Ortho=false, size_t SZ = traits::input_frame_size>struct fast_dct : public Processor1A1B<SZ, SZ>, virtual public creatable<fast_dct<traits, DctType, Ortho, SZ> >
+            {
+                fast_dct_impl<SZ, DctType, Ortho> impl_;
+
+            public:
+                virtual const std::string type() const override { return "fast discrete cosine transform"; }
+
+                void process() final
+                {
+                    impl_.transform(this->in, this->out);
+                }
+
+                // default constructor needed for factory creation
+                explicit fast_dct() {}
+
+                fast_dct(params& args) : fast_dct()
+                {
+                }
+            };
         } // proc
     } // eng
 } //sel
@@ -119,32 +226,89 @@ SEL_UNIT_TEST(dct)
 
         void run() {
 
-            auto py_dct = python::get().scipy_fftpack.attr("dct");
-
             rng rng1;
 
             std::vector<sel::eng6::Processor1A1B<ut_traits::input_frame_size, ut_traits::input_frame_size>* > dcts = {
                     new dct<1>, new dct<2>, new dct<3>, new dct<4>
             };
 
-            size_t dct_type = 0;
             rng1.process();
+            for (auto pdct: dcts) {
+                pdct->ConnectFrom(rng1);
+                pdct->freeze();
+                pdct->process();
+            }
 
-            const char *dct_type_names[] = { "n/a", "Type I", "Type II", "Type III", "Type IV" };
-            for (auto pdct: dcts ) {
-                ++dct_type; // iterates through 1,2,3,4
-                SEL_UNIT_TEST_ITEM(dct_type_names[dct_type]);
+            // fast dct should match the naive one, and be undone by the inverse transform (no Python needed)
+            constexpr size_t N = ut_traits::input_frame_size;
+            sel::eng6::proc::fast_dct<ut_traits, 2> fast_dct2;
+            sel::eng6::proc::fast_dct<ut_traits, 3> fast_dct3;
+            sel::eng6::proc::fast_dct<ut_traits, 2, true> fast_dct2_ortho;
+            sel::eng6::proc::fast_dct<ut_traits, 3, true> fast_dct3_ortho;
+            std::vector<sel::eng6::Processor1A1B<ut_traits::input_frame_size, ut_traits::input_frame_size>* > fast_dcts = {
+                    &fast_dct2, &fast_dct3, &fast_dct2_ortho, &fast_dct3_ortho
+            };
+            for (auto pdct : fast_dcts) {
                 pdct->ConnectFrom(rng1);
                 pdct->freeze();
                 pdct->process();
+            }
+            const samp_t *x = rng1.out;
+
+            SEL_UNIT_TEST_ITEM("Fast Type II and III against naive");
+            for (size_t k = 0; k < N; ++k) {
+                SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fast_dct2.out[k], dcts[1]->out[k]);
+                SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fast_dct3.out[k], dcts[2]->out[k]);
+                // orthonormal scaling of type II:  sqrt(1/4N) for bin 0, sqrt(1/2N) for the others
+                SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fast_dct2_ortho.out[k], dcts[1]->out[k] * std::sqrt(1.0 / ((k ? 2 : 4) * N)));
+            }
 
-                auto my_dct_result_vec = pdct->Out(0)->as_vector();
+            SEL_UNIT_TEST_ITEM("Fast Type III inverts Type II");
+            {
+                sel::eng6::proc::fast_dct_impl<N, 2> fwd;
+                sel::eng6::proc::fast_dct_impl<N, 3> inv;
+                sel::eng6::proc::fast_dct_impl<N, 3, true> inv_ortho;
+                std::vector<double> y(N), z(N);
+                fwd.transform(x, y.data());
+                inv.transform(y.data(), z.data());
+                // unnormalized, the round trip scales by 2N
+                for (size_t n = 0; n < N; ++n)
+                    SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(z[n], 2.0 * N * x[n]);
+                inv_ortho.transform(fast_dct2_ortho.out, z.data());
+                for (size_t n = 0; n < N; ++n)
+                    SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(z[n], x[n]);
+            }
+
+            // naive and fast dcts against scipy
+            auto py_dct = python::get().scipy_fftpack.attr("dct");
+
+            const char *dct_type_names[] = { "Type I", "Type II", "Type III", "Type IV" };
+            for (size_t i = 0; i < dcts.size(); ++i) {
+                const size_t dct_type = i + 1;
+                SEL_UNIT_TEST_ITEM(dct_type_names[i]);
+                auto my_dct_result_vec = dcts[i]->Out(0)->as_vector();
                 py::array_t<double> py_dct_result = py_dct(rng1.Out(0)->as_vector(), "type"_a = dct_type);
                 auto py_dct_result_vec = python::make_vector_from_1d_numpy_array(py_dct_result);
-                for (size_t i = 0; i < ut_traits::input_frame_size; ++i)
-                    SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(my_dct_result_vec[i],py_dct_result_vec[i]);
+                for (size_t k = 0; k < N; ++k)
+                    SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(my_dct_result_vec[k], py_dct_result_vec[k]);
+            }
+
+            const char *fast_dct_names[] = { "Fast Type II", "Fast Type III", "Fast Type II (ortho)", "Fast Type III (ortho)" };
+            for (size_t i = 0; i < fast_dcts.size(); ++i) {
+                SEL_UNIT_TEST_ITEM(fast_dct_names[i]);
+                const size_t fast_dct_type = 2 + i % 2;
+                const bool ortho = i >= 2;
+                auto my_dct_result_vec = fast_dcts[i]->Out(0)->as_vector();
+                py::array_t<double> py_dct_result = ortho ?
+                    py_dct(rng1.Out(0)->as_vector(), "type"_a = fast_dct_type, "norm"_a = "ortho") :
+                    py_dct(rng1.Out(0)->as_vector(), "type"_a = fast_dct_type);
+                auto py_dct_result_vec = python::make_vector_from_1d_numpy_array(py_dct_result);
+                for (size_t k = 0; k < N; ++k)
+                    SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(my_dct_result_vec[k], py_dct_result_vec[k]);
             }
 
+            for (auto pdct : dcts)
+                delete pdct;
         }
 
 SEL_UNIT_TEST_END
@@ -17,6 +17,15 @@ namespace sel
 
 				samp_t s_ = NO_SIGNAL; // current ema
 
+				samp_t update_(samp_t x)
+				{
+					if (isnan(s_))  // first time
+						s_ = x;
+					else
+						s_ = x * alpha_ + s_ * (1.0 - alpha_);
+					return s_;
+				}
+
 			public:
 				// https://books.google.co.uk/books?id=Zle0_-zk1nsC&pg=PA797&lpg=PA797
 				// https://pandas.pydata.org/pandas-docs/version/0.17.0/generated/pandas.ewma.html
@@ -28,12 +37,14 @@ namespace sel
 				
 				void process() final
 				{
-					if (isnan(s_))  // first time
-						s_ = *this->in;
-					else
-						s_ = *this->in * alpha_ + s_ * (1.0 - alpha_);
+					*this->out = update_(*this->in);
+				}
 
-					*this->out = s_;
+				bool block_capable() const final { return true; }
+				void process_block(size_t n) final
+				{
+					for (size_t k = 0; k < n; ++k)
+						this->out[k] = update_(this->in[k]);
 				}
 				// default constructor needed for factory creation
 				ewma() = default;
@@ -0,0 +1,141 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../scheduler.h"
+#include "../processor.h"
+#include "../mpmc_queue.h"
+#include "../event.h"
+#include "data_source.h"
+
+namespace sel {
+	namespace eng6 {
+		namespace proc {
+			/*
+			Fan-in:  merges frames of width W from fibers running on several threads into one output,
+			e.g. to feed one numpy or matlab file writer with features computed on many threads.
+
+			Each producing fiber connects to its own add_input(), which queues every frame it is given on a
+			lock-free mpmc_queue.
+
+			On the consuming thread:
+				- the fan_in is the source (and trigger) of the sink's fiber, as a window or resampler is.
+				- pump() must be scheduled with some other trigger (a periodic_event, say).  Each time it runs it
+				  takes every queued frame into the fan_in's output port, and runs the sink's schedule once for each.
+
+			If the queue is full, the producer drains it in the same way itself, so nothing is dropped, and the producer
+			never waits for a pump that can't run until it returns (on a single-threaded scheduler, or on the producer's
+			own worker).  The sink then runs on the producer's thread, but never on two threads at once.
+			Size the queue so that this is rare.
+
+			Frames from one producer come out in the order they went in.  Frames from different producers are interleaved.
+			All inputs must be added, and all schedules initialized, before any of the threads start.
+			*/
+			template<size_t W>class fan_in : public data_source<W>, virtual public creatable<fan_in<W>>
+			{
+				mpmc_queue<samp_t, W>queue_;
+				// At init time, this is set by the output processor
+				schedule* output_context = nullptr;
+
+				struct fan_in_proc_t : Processor1A0<W>
+				{
+					fan_in *owner;
+					explicit fan_in_proc_t(fan_in *f) : owner(f) {}
+
+					void init(schedule *context) final
+					{
+						if (context->trigger() == owner)
+							throw eng_ex("Fan-in input can't be triggered by the fan_in itself.");
+					}
+
+					void process() final
+					{
+						// if another thread is draining the queue already, there will soon be room
+						while (!owner->queue_.try_put(this->in))
+							if (!owner->drain_())
+								std::this_thread::yield();
+					}
+				};
+
+				std::vector<std::unique_ptr<fan_in_proc_t>> inputs_;
+
+				struct pump_t : processor
+				{
+					fan_in *owner;
+					explicit pump_t(fan_in *f) : owner(f) {}
+
+					void init(schedule *context) final
+					{
+						if (context->trigger() == owner)
+							throw eng_ex("Fan-in pump can't be triggered by the fan_in itself.");
+					}
+
+					void process() final
+					{
+						owner->drain_();
+					}
+				} pump_;
+
+				// set while the pump, or a producer that found the queue full, is running the sink
+				std::atomic_flag draining_ = ATOMIC_FLAG_INIT;
+
+				// take every queued frame into the output port, and run the sink's schedule once for each.
+				// Returns false, without waiting, if another thread is doing it already
+				bool drain_()
+				{
+					if (!output_context)
+						throw eng_ex("Fan-in output is not scheduled.");
+					if (draining_.test_and_set(std::memory_order_acquire))
+						return false;
+					struct release_t { std::atomic_flag& flag; ~release_t() { flag.clear(std::memory_order_release); } } release{ draining_ };
+					while (queue_.try_get(this->out))
+						output_context->invoke();
+					return true;
+				}
+
+			public:
+				static constexpr size_t default_capacity = 256;
+
+				virtual const std::string type() const override
+				{
+					char buf[100];
+					snprintf(buf, 100, "fan_in[%zd]", W);
+					return buf;
+				}
+
+				void init(schedule* context) final
+				{
+					if (context->trigger() != this)
+						throw eng_ex("Fan-in output must be triggered by the fan_in itself.");
+					this->output_context = context;
+					context->set_invoked();
+				}
+
+				// the frame was copied into the output port by the pump
+				void process() final {}
+
+				// a new input, for one producing fiber
+				fan_in_proc_t & add_input()
+				{
+					inputs_.push_back(std::make_unique<fan_in_proc_t>(this));
+					return *inputs_.back();
+				}
+				size_t inputs() const { return inputs_.size(); }
+
+				pump_t & pump() { return pump_; }
+
+				// frames queued, approximately
+				size_t get_avail() const { return queue_.get_avail(); }
+
+				// capacity is in frames, and must be a power of two
+				explicit fan_in(size_t capacity = default_capacity) : queue_(capacity), pump_(this) {}
+				explicit fan_in(params& params) : fan_in(params.get<size_t>("capacity", default_capacity)) {}
+			};
+
+		} // proc
+	} // eng
+} // sel
+#if defined(COMPILE_UNIT_TESTS)
+#include "fan_in_ut.h"
+#endif
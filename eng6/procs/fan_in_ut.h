@@ -0,0 +1,163 @@
+#pragma once
+
+// fan_in unit test
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "fan_in.h"
+#include "compound_processor.h"
+#include "../unit_test.h"
+
+SEL_UNIT_TEST(fan_in)
+
+struct ut_traits
+{
+	static constexpr size_t frame_size = 3;
+	static constexpr size_t producers = 3;
+	static constexpr size_t frames_per_producer = 20000;
+	static constexpr size_t queue_size = 16;
+};
+
+using fan_in = sel::eng6::proc::fan_in<ut_traits::frame_size>;
+
+// frame n of producer p is { p, n, p + n }
+struct counter_source : sel::eng6::Processor01A<ut_traits::frame_size>
+{
+	const samp_t p;
+	samp_t n = 0;
+	explicit counter_source(size_t p) : p(static_cast<samp_t>(p)) {}
+	void process() final
+	{
+		out[0] = p; out[1] = n; out[2] = p + n;
+		++n;
+	}
+};
+
+// any sink:  checks each producer's frames arrive whole and in order
+struct check_sink : sel::eng6::Processor1A0<ut_traits::frame_size>
+{
+	size_t frames = 0;
+	size_t errors = 0;
+	std::vector<samp_t> next = std::vector<samp_t>(ut_traits::producers);
+	void process() final
+	{
+		++frames;
+		const auto p = static_cast<size_t>(in[0]);
+		if (p >= ut_traits::producers || in[1] != next[p] || in[2] != in[0] + in[1])
+			++errors;
+		else
+			++next[p];
+	}
+};
+
+void run()
+{
+	fan_in fan(ut_traits::queue_size);
+	check_sink sink;
+
+	// one fiber per producer thread
+	std::vector<std::unique_ptr<counter_source>> sources;
+	std::vector<std::unique_ptr<sel::eng6::proc::compound_processor>> fibers;
+	std::vector<std::unique_ptr<sel::eng6::semaphore>> triggers;
+	std::vector<sel::eng6::schedule> producer_schedules;
+	producer_schedules.reserve(ut_traits::producers);
+	for (size_t p = 0; p < ut_traits::producers; ++p) {
+		sources.push_back(std::make_unique<counter_source>(p));
+		fibers.push_back(std::make_unique<sel::eng6::proc::compound_processor>());
+		triggers.push_back(std::make_unique<sel::eng6::semaphore>());
+		fibers.back()->connect_procs(*sources.back(), fan.add_input());
+		producer_schedules.emplace_back(triggers.back().get(), *fibers.back());
+	}
+	SEL_UNIT_TEST_ASSERT(fan.inputs() == ut_traits::producers);
+
+	// the sink's fiber, and the pump, on this thread
+	sel::eng6::proc::compound_processor output_proc;
+	output_proc.connect_procs(fan, sink);
+	sel::eng6::semaphore pump_trigger;
+	sel::eng6::schedule output_schedule(&fan, output_proc);
+	sel::eng6::schedule pump_schedule(&pump_trigger, fan.pump());
+
+	SEL_UNIT_TEST_ITEM("triggers");
+	{
+		bool threw_exception = false;
+		try {
+			sel::eng6::schedule(&pump_trigger, output_proc).init();
+		}
+		catch (sel::eng_ex&) {
+			threw_exception = true;
+		}
+		SEL_UNIT_TEST_ASSERT(threw_exception);
+
+		threw_exception = false;
+		try {
+			sel::eng6::schedule(&fan, fan.pump()).init();
+		}
+		catch (sel::eng_ex&) {
+			threw_exception = true;
+		}
+		SEL_UNIT_TEST_ASSERT(threw_exception);
+	}
+
+	SEL_UNIT_TEST_ITEM("fan in from threads");
+	for (auto& s : producer_schedules)
+		s.init();
+	output_schedule.init();
+	pump_schedule.init();
+
+	// the producers also run the sink when they find the queue full, so only look at it once they are done
+	std::atomic<size_t> producers_done{ 0 };
+	std::vector<std::thread> threads;
+	for (auto& s : producer_schedules)
+		threads.emplace_back([&s, &producers_done] { s.invoke(ut_traits::frames_per_producer); ++producers_done; });
+
+	const size_t total = ut_traits::producers * ut_traits::frames_per_producer;
+	while (producers_done < ut_traits::producers) {
+		pump_schedule.invoke();
+		std::this_thread::yield();
+	}
+	for (auto& t : threads)
+		t.join();
+	pump_schedule.invoke();
+
+	SEL_UNIT_TEST_ASSERT(sink.errors == 0);
+	SEL_UNIT_TEST_ASSERT(sink.frames == total);
+	for (size_t p = 0; p < ut_traits::producers; ++p)
+		SEL_UNIT_TEST_ASSERT(sink.next[p] == ut_traits::frames_per_producer);
+	SEL_UNIT_TEST_ASSERT(fan.get_avail() == 0);
+
+	// a single-threaded scheduler can't run the pump while a producer waits for room, so the producer drains the queue
+	SEL_UNIT_TEST_ITEM("producer outpaces the pump");
+	{
+		fan_in fan1(ut_traits::queue_size);
+		check_sink sink1;
+		counter_source source1(0);
+		sel::eng6::proc::compound_processor producer_fiber, output_fiber;
+		producer_fiber.connect_procs(source1, fan1.add_input());
+		output_fiber.connect_procs(fan1, sink1);
+		sel::eng6::semaphore producer_trigger, pump_trigger1;
+
+		sel::eng6::scheduler s = {};
+		s.add(&producer_trigger, producer_fiber);
+		s.add(&pump_trigger1, fan1.pump());
+		s.add(&fan1, output_fiber);
+		s.init();
+
+		// the pump runs once for every 10 queues full
+		const size_t frames = 100 * ut_traits::queue_size;
+		producer_trigger.raise(frames);
+		for (size_t i = 0; i < frames; ++i) {
+			if (i % (10 * ut_traits::queue_size) == 0)
+				pump_trigger1.raise();
+			s.step();
+		}
+		pump_trigger1.raise();
+		s.step();
+
+		SEL_UNIT_TEST_ASSERT(sink1.errors == 0);
+		SEL_UNIT_TEST_ASSERT(sink1.frames == frames);
+		SEL_UNIT_TEST_ASSERT(sink1.next[0] == frames);
+		SEL_UNIT_TEST_ASSERT(fan1.get_avail() == 0);
+	}
+}
+
+SEL_UNIT_TEST_END
@@ -2,6 +2,7 @@
 #include "../eng_traits.h"
 #include "../processor.h"
 #include "fft_impl.h"
+#include "fft_plan.h"
 //template<size_t SZ>class sp_ac;
 namespace sel {
 	namespace eng6 {
@@ -13,7 +14,8 @@ namespace sel {
 
 				friend class unit_test_fft;
 
-				GFFT<SZ, samp_t, 1> gfft;
+				// GFFT if SZ is a power of two, otherwise a mixed-radix or Bluestein plan
+				fixed_fft<SZ, samp_t, fft_direction::forward> fft_;
 
 			public:
 
@@ -35,7 +37,7 @@ namespace sel {
 					for (size_t i = 0; i < SZ; ++i)
 						out_as_complex_array[i] = this->in[i];
 
-					gfft.fft(this->out);
+					fft_.execute(this->out);
 
 				}
 				// default constuctor needed for factory creation
@@ -53,15 +55,9 @@ namespace sel {
 
 				friend class unit_test_fft;
 
-				GFFT<SZ, samp_t, 1> gfft;
-
-				// Unlike full fft, which transforms the output port 'in place',  real fft needs an internal buffer
-				// This is because although we only have the output array size of N/2+1  but still need
-				// the full N for the fft calculation itself.
-				
-				csamp_t complex_data[SZ];
-				// 
-				samp_t * const data_as_array_of_reals = reinterpret_cast<samp_t *>(&complex_data[0]);
+				// N-point real fft, done as an N/2-point complex fft (if N is even).
+				// The output port has room for the N reals (as N/2 complex values), so the transform is done 'in place'
+				fixed_rfft<SZ, samp_t> grfft;
 
 			public:
 
@@ -76,29 +72,86 @@ namespace sel {
 
 				void process(void)
 				{
+					std::copy(this->in, this->in + SZ, this->out);
 
-					// real input, convert to complex (via operator=())
-					for (size_t i = 0; i < SZ; ++i)
-						complex_data[i] = this->in[i];
+					grfft.fft(this->out);
+
+				}
+				// default constuctor needed for factory creation
+				explicit fftr_t() {}
+
+				fftr_t(params& args)
+				{
+				}
 
-					gfft.fft(data_as_array_of_reals);
 
-					// ignore conjugates
-					for (size_t i = 0; i < 2 * (SZ / 2 + 1); ++i)
-						this->out[i] = data_as_array_of_reals[i];
+			};
 
+			// inverse of fftr_t.  Input is the N/2+1 non-redundant bins of the spectrum of a real signal, output is the N real samples
+			template<typename traits> struct ifftr_t : public Processor1A1B<2 * (traits::input_frame_size / 2 + 1), traits::input_frame_size>, virtual public creatable<ifftr_t<traits> >
+			{
+				static constexpr size_t SZ = traits::input_frame_size;
 
+				friend class unit_test_fft;
+
+				fixed_rfft<SZ, samp_t> grfft;
+
+			public:
+
+
+				const std::string type() const final
+				{
+					char buf[100];
+					snprintf(buf, 100, "ifftr[%zd]", SZ);
+					return buf;
+				}
+
+
+				void process(void)
+				{
+					grfft.ifft(this->in, this->out);
 				}
 				// default constuctor needed for factory creation
-				explicit fftr_t() {}
+				explicit ifftr_t() {}
 
-				fftr_t(params& args)
+				ifftr_t(params& args)
 				{
 				}
 
 
 			};
 
+			// window (a wintype of window.h) then real fft, in one processor: the windowed frame is written straight into the fft's
+			// buffer (the output port), instead of into a port of its own that fftr_t then copies.  Output as fftr_t
+			template<typename traits, typename wintype> struct windowed_fftr_t :
+				public Processor1A1B<traits::input_frame_size, 2 * (traits::input_frame_size / 2 + 1)>, virtual public creatable<windowed_fftr_t<traits, wintype>>
+			{
+				static constexpr size_t SZ = traits::input_frame_size;
+
+				fixed_rfft<SZ, samp_t> grfft;
+
+			public:
+				const std::string type() const final
+				{
+					char buf[100];
+					snprintf(buf, 100, "%s_fftr[%zd]", wintype::name(), SZ);
+					return buf;
+				}
+
+				void process() final
+				{
+					wintype::template process_buffer<SZ>(this->in, this->out);
+					grfft.fft(this->out);
+				}
+
+				// default constructor needed for factory creation
+				explicit windowed_fftr_t() {}
+
+				windowed_fftr_t(params& args)
+				{
+				}
+			};
+
 
 			template<typename traits = eng_traits<>>struct ifft : public Processor1A1B<2 * traits::input_frame_size, 2 * traits::input_frame_size>, virtual public creatable<ifft<traits> >
 			{
@@ -106,25 +159,16 @@ namespace sel {
 
 				//	friend class sp_ac<SZ>;
 				friend class unit_test_fft;
-				GFFT<SZ, samp_t, 1> gfft;
+				fixed_fft<SZ, samp_t, fft_direction::inverse> ifft_;
 
 
 			public:
 				virtual const std::string type() const override { return "ifft";  }
 				void process() final
 				{
-					const csamp_t *in_as_complex_array = (csamp_t *)this->in;
-					csamp_t *out_as_complex_array = (csamp_t *)this->out;
-					// complex input, do conj and also copy  to out (which is changed in-place by fft)
-					for (size_t i = 0; i < SZ; ++i) {
-						out_as_complex_array[i] = std::conj(in_as_complex_array[i]);
-					}
-					gfft.fft(this->out);
-
-					// conj again
-					for (size_t i = 0; i < SZ; ++i) {
-						out_as_complex_array[i] = std::conj(out_as_complex_array[i]) / (double)SZ;
-					}
+					// complex input, copy to out (which is changed in-place by the transform)
+					std::copy(this->in, this->in + 2 * SZ, this->out);
+					ifft_.execute(this->out);
 
 				}
 
@@ -136,6 +180,157 @@ namespace sel {
 				}
 
 			};
+			// fft whose size is set at run time, from the "size" param or (if that is absent) from the width of the connected input.
+			// Real input, complex output, as fft_t.
+			struct fft_n : public Processor<1, 1>, virtual public creatable<fft_n>
+			{
+				friend class unit_test_fft;
+
+				size_t size_ = 0;
+				std::shared_ptr<const fft_plan<samp_t>> plan_;
+				const double *in = nullptr;
+				double *out = nullptr;
+
+			public:
+				const std::string type() const final { return "fft_n"; }
+
+				void freeze() override
+				{
+					port *piport = inports[0];
+					if (!size_)
+						size_ = piport->width();
+					if (piport->width() != size_)
+						throw sp_ex_pin_arity();
+					piport->freezewidth(size_);
+					outports[0]->freezewidth(2 * size_);
+					Connectable::freeze();
+
+					in = piport->as_array();
+					out = outports[0]->as_array();
+					plan_ = fft_plan_cache::get().plan<samp_t>(size_, fft_direction::forward);
+				}
+
+				void process() final
+				{
+					csamp_t *out_as_complex_array = reinterpret_cast<csamp_t *>(out);
+					for (size_t i = 0; i < size_; ++i)
+						out_as_complex_array[i] = in[i];
+
+					plan_->execute(out);
+				}
+
+				// default constuctor needed for factory creation
+				explicit fft_n() {}
+
+				explicit fft_n(size_t size) : size_(size) {}
+
+				fft_n(params& args) : size_(args.get<size_t>("size", 0))
+				{
+				}
+			};
+
+			// inverse of fft_n:  complex input and output.  "size" is the number of complex values
+			struct ifft_n : public Processor<1, 1>, virtual public creatable<ifft_n>
+			{
+				friend class unit_test_fft;
+
+				size_t size_ = 0;
+				std::shared_ptr<const fft_plan<samp_t>> plan_;
+				const double *in = nullptr;
+				double *out = nullptr;
+
+			public:
+				const std::string type() const final { return "ifft_n"; }
+
+				void freeze() override
+				{
+					port *piport = inports[0];
+					if (!size_)
+						size_ = piport->width() / 2;
+					if (piport->width() != 2 * size_)
+						throw sp_ex_pin_arity();
+					piport->freezewidth(2 * size_);
+					outports[0]->freezewidth(2 * size_);
+					Connectable::freeze();
+
+					in = piport->as_array();
+					out = outports[0]->as_array();
+					plan_ = fft_plan_cache::get().plan<samp_t>(size_, fft_direction::inverse);
+				}
+
+				void process() final
+				{
+					std::copy(in, in + 2 * size_, out);
+					plan_->execute(out);
+				}
+
+				// default constuctor needed for factory creation
+				explicit ifft_n() {}
+
+				explicit ifft_n(size_t size) : size_(size) {}
+
+				ifft_n(params& args) : size_(args.get<size_t>("size", 0))
+				{
+				}
+			};
+
+			// K ffts at once, of K frames (or K channels) of SZ real samples, concatenated on the input port.
+			// The output is the K complex spectra, concatenated, each laid out as the output of fft_t.
+			// Internally the frames are transposed to structure-of-arrays order, so that each butterfly is
+			// vectorized across the K transforms.  SZ must be a power of two.
+			template<typename traits, size_t K> struct fft_batch_t : public Processor1A1B<K * traits::input_frame_size, 2 * K * traits::input_frame_size>, virtual public creatable<fft_batch_t<traits, K> >
+			{
+				static constexpr size_t SZ = traits::input_frame_size;
+				static_assert(fft_is_pow2<SZ>, "fft_batch_t: frame size must be a power of two");
+				static_assert(K > 0, "fft_batch_t: at least one frame");
+
+				friend class unit_test_fft;
+
+				GFFT_SOA<SZ, samp_t, 1> fft_;
+				std::vector<samp_t> re_ = std::vector<samp_t>(SZ * K);
+				std::vector<samp_t> im_ = std::vector<samp_t>(SZ * K);
+
+			public:
+
+				const std::string type() const final
+				{
+					char buf[100];
+					snprintf(buf, 100, "fft_batch[%zd,%zd]", SZ, K);
+					return buf;
+				}
+
+				void process(void)
+				{
+					samp_t *re = re_.data();
+					samp_t *im = im_.data();
+
+					// transpose in: sample j of frame k goes to re[j*K + k]
+					for (size_t k = 0; k < K; ++k) {
+						const samp_t *frame = this->in + k * SZ;
+						for (size_t j = 0; j < SZ; ++j)
+							re[j * K + k] = frame[j];
+					}
+					std::fill(im, im + SZ * K, samp_t(0));
+
+					fft_.fft(re, im, K);
+
+					// transpose out
+					for (size_t k = 0; k < K; ++k) {
+						samp_t *spectrum = this->out + 2 * k * SZ;
+						for (size_t j = 0; j < SZ; ++j) {
+							spectrum[2 * j] = re[j * K + k];
+							spectrum[2 * j + 1] = im[j * K + k];
+						}
+					}
+				}
+				// default constuctor needed for factory creation
+				explicit fft_batch_t() {}
+
+				fft_batch_t(params& args)
+				{
+				}
+			};
+
 #if 0
 			template<size_t SZ, size_t OUTSZ>class sp_ac : public  RegisterableSigProc<sp_ac<SZ, OUTSZ>, SZ, OUTSZ>
 			{
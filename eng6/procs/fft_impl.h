@@ -11,10 +11,20 @@
  using template metaprogramming
 
  ***************************************************************************/
-
+#pragma once
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <complex>
+#include <vector>
+#include <algorithm>
+
+#include "fft_simd.h"
+#include "trig_tables.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
 
 using namespace std;
 
@@ -78,59 +88,125 @@ struct Cos<B, A, double> {
 };
 
 
-////// template class DanielsonLanczos
-// Danielson-Lanczos section of the FFT
+////// fft_tables
+// Twiddle factor and bit-reversal tables, one per (N, T, SIGN), shared by every FFT instance.
+// Tables up to max_constexpr_size are built at compile time, and live in read-only data.
+// Larger ones would take too long to evaluate in the compiler, and are built (by the same code) on first use.
 
-template<unsigned N, typename T=double, int SIGN = 1>
-class DanielsonLanczos {
-    DanielsonLanczos<N / 2, T, SIGN> next;
-    T coeffs[N];
+namespace fft_tables {
 
-    static constexpr T wpr = -2.0 * SIGN * Sin<N, 1, T>::value() * SIGN * Sin<N, 1, T>::value();
-    static constexpr T wpi = -SIGN * Sin<N, 2, T>::value();
-public:
-    DanielsonLanczos() {
-        T wr = 1.0;
-        T wi = 0.0;
-        coeffs[0] = wr;
-        coeffs[1] = wi;
-        for (unsigned i = 2; i < N; i+=2) {
-            const auto temp = wr;
-            wr += wr * wpr - wi * wpi;
-            wi += wi * wpr + temp * wpi;
-            coeffs[i] = wr;
-            coeffs[i + 1] = wi;
+    using trig_tables::max_constexpr_size;
+    using trig_tables::sincos_2pi;
+    using trig_tables::array;
+
+    // w[2k] + i w[2k+1] = e^(-SIGN*2*pi*i*k/n), k = 0..n/2-1
+    template<typename T, int SIGN>
+    constexpr void fill_twiddles(T *w, unsigned n) {
+        for (unsigned k = 0; k < n / 2; ++k) {
+            long double s = 0, c = 0;
+            sincos_2pi(k, n, s, c);
+            w[2 * k] = static_cast<T>(c);
+            w[2 * k + 1] = static_cast<T>(-SIGN * s);
         }
     }
 
+    constexpr unsigned bit_reverse(unsigned i, unsigned n) {
+        unsigned r = 0;
+        for (unsigned m = n >> 1; m; m >>= 1, i >>= 1)
+            r = (r << 1) | (i & 1);
+        return r;
+    }
 
-    void apply(T *data) {
-        T *dataN = data + N;
-        next.apply(data);
-        next.apply(dataN);
+    // number of index pairs (i, j), i < j, exchanged by the bit-reversal permutation of n = 2^b items.
+    // All but the 2^ceil(b/2) bit palindromes are in a pair.
+    constexpr unsigned bit_reverse_swap_count(unsigned n) {
+        unsigned b = 0;
+        while ((1u << b) < n)
+            ++b;
+        return (n - (1u << ((b + 1) / 2))) / 2;
+    }
 
+    // pairs of real offsets (2i, 2j) of the complex values exchanged by the bit-reversal permutation
+    constexpr void fill_bit_reverse(unsigned *pairs, unsigned n) {
+        unsigned p = 0;
+        for (unsigned i = 0; i < n; ++i) {
+            const auto j = bit_reverse(i, n);
+            if (i < j) {
+                pairs[p++] = 2 * i;
+                pairs[p++] = 2 * j;
+            }
+        }
+    }
 
+    template<unsigned N, typename T, int SIGN>
+    inline const T *twiddles() {
+        if constexpr (N <= max_constexpr_size) {
+            static constexpr auto table = [] {
+                array<T, N> w{};
+                fill_twiddles<T, SIGN>(w.v, N);
+                return w;
+            }();
+            return table.v;
+        } else {
+            static const std::vector<T> table = [] {
+                std::vector<T> w(N);
+                fill_twiddles<T, SIGN>(w.data(), N);
+                return w;
+            }();
+            return table.data();
+        }
+    }
+
+    template<unsigned N>
+    inline const unsigned *bit_reverse_pairs() {
+        // at least one element, to keep N <= 2 legal
+        constexpr unsigned SZ = 2 * bit_reverse_swap_count(N) + 1;
+        if constexpr (N <= max_constexpr_size) {
+            static constexpr auto table = [] {
+                array<unsigned, SZ> pairs{};
+                fill_bit_reverse(pairs.v, N);
+                return pairs;
+            }();
+            return table.v;
+        } else {
+            static const std::vector<unsigned> table = [] {
+                std::vector<unsigned> pairs(SZ);
+                fill_bit_reverse(pairs.data(), N);
+                return pairs;
+            }();
+            return table.data();
+        }
+    }
+
+} // fft_tables
 
-//    Change dynamic calculation to the static one
-//      wtemp = sin(M_PI/N);
-//        wtemp = SIGN * Sin<N, 1, T>::value();
-//        wpr = -2.0 * wtemp * wtemp;
-//      wpi = -sin(2*M_PI/N);
 
-//        T wr = 1.0;
-//        T wi = 0.0;
-        for (unsigned i = 0; i < N;) {
+////// template class DanielsonLanczos
+// Danielson-Lanczos section of the FFT
+// Stateless: the twiddle factors for each level come from the shared fft_tables
 
-            const auto tempr = dataN[i] * coeffs[i] - dataN[i + 1] * coeffs[i + 1];
-            const auto tempi = dataN[i] * coeffs[i + 1] + dataN[i + 1] * coeffs[i];
-            dataN[i] = data[i] - tempr;
-            dataN[i + 1] = data[i + 1] - tempi;
-            data[i++] += tempr;
-            data[i++] += tempi;
+template<unsigned N, typename T=double, int SIGN = 1>
+class DanielsonLanczos {
+    using next = DanielsonLanczos<N / 2, T, SIGN>;
+    using next_next = DanielsonLanczos<N / 4, T, SIGN>;
 
-//            const auto temp = wr;
-//            wr += wr * wpr - wi * wpi;
-//            wi += wi * wpr + temp * wpi;
+public:
+    // N >= 16: the two lowest-level stages below this one are fused into one radix-4 pass over the four quarters.
+    // Otherwise, a single radix-2 pass over the two halves.
+    // If SCALE, the outputs of the last pass are multiplied by scale.
+    template<bool SCALE = false>
+    static void apply(T *data, T scale = 1) {
+        const T *coeffs = fft_tables::twiddles<N, T, SIGN>();
+        if constexpr (N >= 16) {
+            next_next::apply(data);
+            next_next::apply(data + N / 2);
+            next_next::apply(data + N);
+            next_next::apply(data + 3 * N / 2);
+            fft_simd::kernels<T, SIGN>::template radix4<SCALE>(data, N / 4, coeffs, fft_tables::twiddles<N / 2, T, SIGN>(), scale);
+        } else {
+            next::apply(data);
+            next::apply(data + N);
+            fft_simd::kernels<T, SIGN>::template radix2<SCALE>(data, N / 2, coeffs, scale);
         }
     }
 };
@@ -139,7 +215,12 @@ public:
 template<typename T, int SIGN>
 class DanielsonLanczos<4,T, SIGN> {
 public:
-   void apply(T* data) {
+   template<bool SCALE = false>
+   static void apply(T* data, T scale = 1) {
+      if constexpr (SCALE)
+         for (unsigned i = 0; i < 8; ++i)
+            data[i] *= scale;
+
       T tr = data[2];
       T ti = data[3];
       data[2] = data[0]-tr;
@@ -147,10 +228,16 @@ public:
       data[0] += tr;
       data[1] += ti;
 
+      // second half, with the twiddle -SIGN*i applied to its odd output
       tr = data[6];
       ti = data[7];
-      data[6] = data[5]-ti;
-      data[7] = tr-data[4];
+      if constexpr (SIGN > 0) {
+         data[6] = data[5]-ti;
+         data[7] = tr-data[4];
+      } else {
+         data[6] = ti-data[5];
+         data[7] = data[4]-tr;
+      }
       data[4] += tr;
       data[5] += ti;
 
@@ -174,7 +261,11 @@ public:
 template<typename T, int SIGN>
 class DanielsonLanczos<2, T, SIGN> {
 public:
-    static void apply(T *data) {
+    template<bool SCALE = false>
+    static void apply(T *data, T scale = 1) {
+        if constexpr (SCALE)
+            for (unsigned i = 0; i < 4; ++i)
+                data[i] *= scale;
         twiddle(data, data+2);
     }
     static void twiddle(std::complex<T>&a, std::complex<T>&b) {
@@ -196,33 +287,191 @@ public:
 template<unsigned N, typename T=double, int SIGN = 1>
 class GFFT {
 //   enum { N = 1<<P };
-    DanielsonLanczos<N, T, SIGN> recursion;
-
-    void scramble(T *data) {
-        unsigned i, m, j = 1;
-        for (i = 1; i < 2 * N; i += 2) {
-            if (j > i) {
-                swap(data[j - 1], data[i - 1]);
-                swap(data[j], data[i]);
-            }
-            m = N;
-            while (m >= 2 && j > m) {
-                j -= m;
-                m >>= 1;
-            }
-            j += m;
+    using recursion = DanielsonLanczos<N, T, SIGN>;
+
+    static void scramble(T *data) {
+        constexpr unsigned count = fft_tables::bit_reverse_swap_count(N);
+        const unsigned *pairs = fft_tables::bit_reverse_pairs<N>();
+        for (unsigned p = 0; p < 2 * count; p += 2) {
+            T *a = data + pairs[p];
+            T *b = data + pairs[p + 1];
+            swap(a[0], b[0]);
+            swap(a[1], b[1]);
         }
     }
 
 public:
     void fft(T *data) {
         scramble(data);
-        recursion.apply(data);
+        recursion::apply(data);
+    }
+
+    // transform, with the outputs multiplied by scale.  GFFT<N, T, -1>().fft(data, T(1) / N) is the inverse of GFFT<N, T, 1>().fft(data)
+    void fft(T *data, T scale) {
+        scramble(data);
+        recursion::template apply<true>(data, scale);
     }
 
 };
 
 
+////// real fft helpers
+// An N-point real fft (N even) is done as an N/2-point complex fft of the packed signal, followed by rfft_split.
+// The inverse is rfft_merge, then an N/2-point inverse complex fft.
+// coeffs holds e^(-2*pi*i*k/N), k = 0..N/4, interleaved.
+
+// data holds the N/2-point complex fft of the packed signal on entry, and the N/2+1 bins (N+2 reals) on exit
+template<typename T>
+void rfft_split(T *data, unsigned N, const T *coeffs) {
+    const unsigned H = N / 2;
+
+    // bins 0 and N/2 are both real, and come from Z[0]
+    const T z0r = data[0];
+    const T z0i = data[1];
+    data[0] = z0r + z0i;
+    data[1] = 0;
+    data[N] = z0r - z0i;
+    data[N + 1] = 0;
+
+    // bins k and N/2-k are computed together from Z[k] and Z[N/2-k]
+    for (unsigned k = 1; k <= N / 4; ++k) {
+        T *zk = data + 2 * k;
+        T *zm = data + 2 * (H - k);
+        const T wr = coeffs[2 * k];
+        const T wi = coeffs[2 * k + 1];
+
+        // even part Fe = (Z[k] + conj(Z[m])) / 2, odd part Fo = (Z[k] - conj(Z[m])) / 2i
+        const T er = (zk[0] + zm[0]) / 2;
+        const T ei = (zk[1] - zm[1]) / 2;
+        const T or_ = (zk[1] + zm[1]) / 2;
+        const T oi = (zm[0] - zk[0]) / 2;
+
+        // W^k * Fo
+        const T tr = wr * or_ - wi * oi;
+        const T ti = wr * oi + wi * or_;
+
+        // X[k] = Fe + W^k Fo, X[N/2-k] = conj(Fe - W^k Fo)
+        zk[0] = er + tr;
+        zk[1] = ei + ti;
+        zm[0] = er - tr;
+        zm[1] = ti - ei;
+    }
+}
+
+// spectrum holds N/2+1 complex values (N+2 reals).  data receives the packed N/2-point spectrum Z,
+// whose N/2-point inverse transform is the N real samples (even samples real, odd samples imaginary)
+template<typename T>
+void rfft_merge(const T *spectrum, T *data, unsigned N, const T *coeffs) {
+    const unsigned H = N / 2;
+    const T x0 = spectrum[0];
+    const T xh = spectrum[N];
+    data[0] = (x0 + xh) / 2;
+    data[1] = (x0 - xh) / 2;
+
+    for (unsigned k = 1; k <= N / 4; ++k) {
+        const T *xk = spectrum + 2 * k;
+        const T *xm = spectrum + 2 * (H - k);
+        const T wr = coeffs[2 * k];
+        const T wi = coeffs[2 * k + 1];
+
+        // Fe = (X[k] + conj(X[m])) / 2, W^k Fo = (X[k] - conj(X[m])) / 2
+        const T er = (xk[0] + xm[0]) / 2;
+        const T ei = (xk[1] - xm[1]) / 2;
+        const T dr = (xk[0] - xm[0]) / 2;
+        const T di = (xk[1] + xm[1]) / 2;
+
+        // Fo = conj(W^k) * (W^k Fo)
+        const T or_ = wr * dr + wi * di;
+        const T oi = wr * di - wi * dr;
+
+        // Z[k] = Fe + i Fo, Z[m] = conj(Fe) + i conj(Fo)
+        T *zk = data + 2 * k;
+        T *zm = data + 2 * (H - k);
+        zk[0] = er - oi;
+        zk[1] = ei + or_;
+        zm[0] = er + oi;
+        zm[1] = or_ - ei;
+    }
+}
+
+////// template class GRFFT
+// real-input fast Fourier transform
+// The N real inputs are treated as N/2 complex values (even samples real, odd samples imaginary),
+// transformed with an N/2-point GFFT, then separated into the N/2+1 non-redundant bins
+// of the N-point spectrum with a single post-twiddle pass.
+
+template<unsigned N, typename T=double>
+class GRFFT {
+    static_assert(N >= 4 && (N & (N - 1)) == 0, "GRFFT: N must be a power of two, and at least 4");
+
+    static constexpr unsigned H = N / 2;
+
+    GFFT<H, T, 1> half;
+    GFFT<H, T, -1> half_inverse;
+
+public:
+
+    // data holds N reals on entry, and N/2+1 complex values (N+2 reals) on exit
+    void fft(T *data) {
+        half.fft(data);
+        rfft_split(data, N, fft_tables::twiddles<N, T, 1>());
+    }
+
+    // spectrum holds N/2+1 complex values (N+2 reals), data receives N reals.
+    // The result is scaled by 1/N, so that ifft(fft(x)) == x
+    void ifft(const T *spectrum, T *data) {
+        rfft_merge(spectrum, data, N, fft_tables::twiddles<N, T, 1>());
+        half_inverse.fft(data, T(1) / H);
+    }
+};
+
+////// template class GFFT_SOA
+// K N-point transforms at once, in structure-of-arrays layout: element j of transform l is (re[j*K + l], im[j*K + l]).
+// Every butterfly is applied to all K transforms together, so the vector kernels run across transforms
+// rather than along them, and need no shuffles.  N must be a power of two.
+
+template<unsigned N, typename T=double, int SIGN = 1>
+class GFFT_SOA {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "GFFT_SOA: N must be a power of two");
+
+    static void scramble(T *re, T *im, unsigned K) {
+        constexpr unsigned count = fft_tables::bit_reverse_swap_count(N);
+        const unsigned *pairs = fft_tables::bit_reverse_pairs<N>();
+        // pairs holds interleaved offsets (2 * index)
+        for (unsigned p = 0; p < 2 * count; p += 2) {
+            const unsigned a = pairs[p] / 2 * K;
+            const unsigned b = pairs[p + 1] / 2 * K;
+            std::swap_ranges(re + a, re + a + K, re + b);
+            std::swap_ranges(im + a, im + a + K, im + b);
+        }
+    }
+
+    // all the stages up to and including the LEN-point one, paired into radix-4 passes as in DanielsonLanczos
+    template<unsigned LEN>
+    static void stages(T *re, T *im, unsigned K) {
+        using kernels = fft_simd::kernels<T, SIGN>;
+        const T *w = fft_tables::twiddles<LEN, T, SIGN>();
+        if constexpr (LEN >= 16) {
+            stages<LEN / 4>(re, im, K);
+            const T *w2 = fft_tables::twiddles<LEN / 2, T, SIGN>();
+            for (unsigned b = 0; b < N; b += LEN)
+                kernels::radix4_soa(re + b * K, im + b * K, LEN / 4, K, w, w2);
+        } else {
+            if constexpr (LEN > 2)
+                stages<LEN / 2>(re, im, K);
+            for (unsigned b = 0; b < N; b += LEN)
+                kernels::radix2_soa(re + b * K, im + b * K, LEN / 2, K, w);
+        }
+    }
+
+public:
+    void fft(T *re, T *im, unsigned K) {
+        scramble(re, im, K);
+        stages<N>(re, im, K);
+    }
+};
+
+
 
 /*
 int main()
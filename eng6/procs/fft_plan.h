@@ -0,0 +1,445 @@
+#pragma once
+/*
+	FFT plans for sizes only known at run time
+
+	A plan does an in-place complex FFT of a fixed size.  Plans are obtained from fft_plan_cache, which
+	keeps one plan per (size, direction, precision), shared by every processor that asks for it.
+
+	Power of two sizes in [2^min_precompiled_log2, 2^max_precompiled_log2] use the compile-time GFFT specializations.
+	Other power of two sizes use a generic radix-2 plan, whose tables are built when the plan is created.
+	Sizes whose only prime factors are 2, 3 and 5 (e.g. 400, for 25ms frames at 16kHz) use a mixed-radix plan.
+	Any other size uses Bluestein's algorithm, which does the transform as a convolution of power of two size.
+*/
+#include <complex>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include "fft_impl.h"
+#include "../msg_and_error.h"
+
+namespace sel {
+	namespace eng6 {
+		namespace proc {
+
+			enum class fft_direction { forward, inverse };
+
+			template<typename T>struct fft_plan
+			{
+				virtual ~fft_plan() = default;
+
+				virtual size_t size() const = 0;
+
+				// transform size() complex values (2 * size() interleaved reals) in place.
+				// The inverse transform is scaled by 1/size(), so that inverse(forward(x)) == x
+				virtual void execute(T *data) const = 0;
+			};
+
+			namespace fft_plans {
+
+				static constexpr unsigned min_precompiled_log2 = 2;
+				static constexpr unsigned max_precompiled_log2 = 12;	// fft_tables::max_constexpr_size
+
+				// plan using a compile-time GFFT specialization
+				template<unsigned N, typename T, fft_direction DIR>struct gfft_plan : fft_plan<T>
+				{
+					size_t size() const final { return N; }
+
+					void execute(T *data) const final
+					{
+						if constexpr (DIR == fft_direction::forward)
+							GFFT<N, T, 1>().fft(data);
+						else
+							// 1/N is folded into the last pass
+							GFFT<N, T, -1>().fft(data, T(1) / N);
+					}
+				};
+
+				// generic plan for any power of two size: bit-reversal, then log2(N) radix-2 passes
+				template<typename T, fft_direction DIR>class radix2_plan : public fft_plan<T>
+				{
+					static constexpr int SIGN = DIR == fft_direction::forward ? 1 : -1;
+
+					const size_t n_;
+					std::vector<unsigned> bit_reverse_pairs_;
+					// twiddles for the pass combining blocks of len complex values are at offset 2 * (len/2 - 1)
+					std::vector<T> twiddles_;
+
+				public:
+					size_t size() const final { return n_; }
+
+					void execute(T *data) const final
+					{
+						for (size_t p = 0; p < bit_reverse_pairs_.size(); p += 2) {
+							T *a = data + bit_reverse_pairs_[p];
+							T *b = data + bit_reverse_pairs_[p + 1];
+							std::swap(a[0], b[0]);
+							std::swap(a[1], b[1]);
+						}
+
+						for (size_t len = 2; len <= n_; len *= 2) {
+							const T *w = twiddles_.data() + 2 * (len / 2 - 1);
+							for (size_t block = 0; block < n_; block += len)
+								fft_simd::kernels<T, SIGN>::radix2(data + 2 * block, static_cast<unsigned>(len / 2), w);
+						}
+
+						if constexpr (DIR == fft_direction::inverse) {
+							const T scale = T(1) / n_;
+							for (size_t i = 0; i < 2 * n_; ++i)
+								data[i] *= scale;
+						}
+					}
+
+					explicit radix2_plan(size_t n) :
+						n_(n),
+						bit_reverse_pairs_(2 * fft_tables::bit_reverse_swap_count(static_cast<unsigned>(n)) + 1),
+						twiddles_(2 * n)
+					{
+						fft_tables::fill_bit_reverse(bit_reverse_pairs_.data(), static_cast<unsigned>(n));
+						bit_reverse_pairs_.pop_back();
+						for (size_t len = 2; len <= n; len *= 2)
+							fft_tables::fill_twiddles<T, SIGN>(twiddles_.data() + 2 * (len / 2 - 1), static_cast<unsigned>(len));
+					}
+				};
+
+				template<typename T, fft_direction DIR, unsigned LOG2 = min_precompiled_log2>
+				std::shared_ptr<fft_plan<T>> make_precompiled(size_t n)
+				{
+					if (n == size_t(1) << LOG2)
+						return std::make_shared<gfft_plan<1u << LOG2, T, DIR>>();
+					if constexpr (LOG2 < max_precompiled_log2)
+						return make_precompiled<T, DIR, LOG2 + 1>(n);
+					else
+						return nullptr;
+				}
+
+				// complex multiply, without the inf/nan checks std::complex's operator* does
+				template<typename T>std::complex<T> cmul(const std::complex<T>& a, const std::complex<T>& w)
+				{
+					return std::complex<T>(a.real() * w.real() - a.imag() * w.imag(), a.real() * w.imag() + a.imag() * w.real());
+				}
+
+				// Stockham autosort mixed-radix plan, for sizes whose only prime factors are 2, 3 and 5.
+				// Each pass does size/p radix-p butterflies, reading from one buffer and writing in order to the other,
+				// so no bit-reversal is needed.  The passes are vectorized (fft_simd::kernels::stockham)
+				template<typename T, fft_direction DIR>class mixed_radix_plan : public fft_plan<T>
+				{
+					static constexpr int SIGN = DIR == fft_direction::forward ? 1 : -1;
+
+					const size_t n_;
+					std::vector<unsigned> radices_;
+					// per pass, the twiddles w^(u*q), u = 1..p-1, for each of the len/p butterflies:  m = len/p for each u in turn
+					std::vector<T> twiddles_;
+
+				public:
+					// factors n into radices 4, 2, 3 and 5.  Returns false if n has any other prime factor
+					static bool factorize(size_t n, std::vector<unsigned>& radices)
+					{
+						radices.clear();
+						if (n < 2)
+							return false;
+						for (unsigned p : { 4u, 2u, 3u, 5u })
+							while (n % p == 0) {
+								radices.push_back(p);
+								n /= p;
+							}
+						return n == 1;
+					}
+
+					size_t size() const final { return n_; }
+
+					void execute(T *data) const final
+					{
+						thread_local std::vector<T> scratch;
+						scratch.resize(2 * n_);
+
+						T *x = data;
+						T *y = scratch.data();
+						const T *w = twiddles_.data();
+						size_t len = n_;
+						size_t stride = 1;
+
+						for (unsigned p : radices_) {
+							const auto m = static_cast<unsigned>(len / p);
+							const auto st = static_cast<unsigned>(stride);
+							switch (p) {
+							case 2: fft_simd::kernels<T, SIGN>::template stockham<2>(x, y, m, st, w); break;
+							case 3: fft_simd::kernels<T, SIGN>::template stockham<3>(x, y, m, st, w); break;
+							case 4: fft_simd::kernels<T, SIGN>::template stockham<4>(x, y, m, st, w); break;
+							case 5: fft_simd::kernels<T, SIGN>::template stockham<5>(x, y, m, st, w); break;
+							}
+							w += 2 * m * (p - 1);
+							len /= p;
+							stride *= p;
+							std::swap(x, y);
+						}
+
+						if (x != data)
+							std::copy(x, x + 2 * n_, data);
+
+						if constexpr (DIR == fft_direction::inverse) {
+							const T scale = T(1) / n_;
+							for (size_t i = 0; i < 2 * n_; ++i)
+								data[i] *= scale;
+						}
+					}
+
+					explicit mixed_radix_plan(size_t n) : n_(n)
+					{
+						if (!factorize(n, radices_))
+							throw eng_ex(format_message("mixed_radix_plan: size %zd has prime factors other than 2, 3 and 5.", n));
+
+						size_t len = n;
+						for (unsigned p : radices_) {
+							const size_t m = len / p;
+							for (unsigned u = 1; u < p; ++u)
+								for (size_t q = 0; q < m; ++q) {
+									long double s = 0, c = 0;
+									fft_tables::sincos_2pi(u * q, len, s, c);
+									twiddles_.push_back(static_cast<T>(c));
+									twiddles_.push_back(static_cast<T>(-SIGN * s));
+								}
+							len = m;
+						}
+					}
+				};
+
+				template<typename T, fft_direction DIR>std::shared_ptr<fft_plan<T>> make(size_t n);
+
+				// Bluestein's algorithm, for sizes with large prime factors.
+				// With nk = (k^2 + n^2 - (k-n)^2) / 2, the DFT becomes a convolution with the chirp e^(-SIGN*pi*i*k^2/n),
+				// which is done with power of two ffts of at least 2n-1 points.
+				template<typename T, fft_direction DIR>class bluestein_plan : public fft_plan<T>
+				{
+					using complex = std::complex<T>;
+					static constexpr int SIGN = DIR == fft_direction::forward ? 1 : -1;
+
+					const size_t n_;
+					size_t m_ = 1;
+					std::vector<complex> chirp_;
+					// fft of the conjugate chirp, scaled by 1/m
+					std::vector<complex> kernel_;
+					std::shared_ptr<fft_plan<T>> forward_;
+
+				public:
+					size_t size() const final { return n_; }
+
+					void execute(T *data) const final
+					{
+						thread_local std::vector<complex> scratch;
+						scratch.assign(m_, complex(0));
+
+						complex *x = reinterpret_cast<complex *>(data);
+						for (size_t k = 0; k < n_; ++k)
+							scratch[k] = cmul(x[k], chirp_[k]);
+
+						// convolve with the kernel.  The inverse fft is done as conj(fft(conj(.)))
+						forward_->execute(reinterpret_cast<T *>(scratch.data()));
+						for (size_t k = 0; k < m_; ++k)
+							scratch[k] = std::conj(cmul(scratch[k], kernel_[k]));
+						forward_->execute(reinterpret_cast<T *>(scratch.data()));
+
+						const T scale = DIR == fft_direction::inverse ? T(1) / n_ : T(1);
+						for (size_t k = 0; k < n_; ++k)
+							x[k] = cmul(std::conj(scratch[k]), chirp_[k]) * scale;
+					}
+
+					explicit bluestein_plan(size_t n) : n_(n), chirp_(n)
+					{
+						while (m_ < 2 * n - 1)
+							m_ *= 2;
+
+						for (size_t k = 0; k < n; ++k) {
+							// k^2 mod 2n keeps the angle exact for large k
+							const unsigned long long k2 = (static_cast<unsigned long long>(k) * k) % (2 * n);
+							long double s = 0, c = 0;
+							fft_tables::sincos_2pi(k2, 2 * n, s, c);
+							chirp_[k] = complex(static_cast<T>(c), static_cast<T>(-SIGN * s));
+						}
+
+						forward_ = make<T, fft_direction::forward>(m_);
+						kernel_.assign(m_, complex(0));
+						kernel_[0] = std::conj(chirp_[0]);
+						for (size_t k = 1; k < n; ++k)
+							kernel_[k] = kernel_[m_ - k] = std::conj(chirp_[k]);
+						forward_->execute(reinterpret_cast<T *>(kernel_.data()));
+						for (auto& v : kernel_)
+							v /= static_cast<T>(m_);
+					}
+				};
+
+				template<typename T, fft_direction DIR>std::shared_ptr<fft_plan<T>> make(size_t n)
+				{
+					if (n < 2)
+						throw eng_ex(format_message("No FFT plan for size %zd.", n));
+					if (!(n & (n - 1))) {
+						if (auto plan = make_precompiled<T, DIR>(n))
+							return plan;
+						return std::make_shared<radix2_plan<T, DIR>>(n);
+					}
+					std::vector<unsigned> radices;
+					if (mixed_radix_plan<T, DIR>::factorize(n, radices))
+						return std::make_shared<mixed_radix_plan<T, DIR>>(n);
+					return std::make_shared<bluestein_plan<T, DIR>>(n);
+				}
+
+			} // fft_plans
+
+			class fft_plan_cache
+			{
+				// (size, direction, precision in bytes)
+				using key = std::tuple<size_t, fft_direction, size_t>;
+
+				std::mutex mutex_;
+				std::map<key, std::shared_ptr<void>> plans_;
+
+				fft_plan_cache() = default;
+
+			public:
+				fft_plan_cache(const fft_plan_cache&) = delete;
+				fft_plan_cache& operator=(const fft_plan_cache&) = delete;
+
+				static fft_plan_cache& get()
+				{
+					static fft_plan_cache instance;
+					return instance;
+				}
+
+				// Returns the shared plan for this size and direction, creating it on first request.
+				template<typename T>std::shared_ptr<const fft_plan<T>> plan(size_t size, fft_direction direction)
+				{
+					const key k{ size, direction, sizeof(T) };
+
+					std::lock_guard<std::mutex> lock(mutex_);
+					auto it = plans_.find(k);
+					if (it == plans_.end()) {
+						std::shared_ptr<fft_plan<T>> plan = direction == fft_direction::forward
+							? fft_plans::make<T, fft_direction::forward>(size)
+							: fft_plans::make<T, fft_direction::inverse>(size);
+						it = plans_.emplace(k, plan).first;
+					}
+					return std::static_pointer_cast<const fft_plan<T>>(it->second);
+				}
+
+				size_t size()
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					return plans_.size();
+				}
+			};
+
+			// real-input fft of any size.  Even sizes are done as a half-size complex fft of the packed signal (as GRFFT),
+			// odd sizes as a full size complex fft.
+			template<typename T>class rfft_plan
+			{
+				using complex = std::complex<T>;
+
+				const size_t n_;
+				std::shared_ptr<const fft_plan<T>> forward_;
+				std::shared_ptr<const fft_plan<T>> inverse_;
+				// even sizes: e^(-2*pi*i*k/N), k = 0..N/4, interleaved
+				std::vector<T> coeffs_;
+
+			public:
+				size_t size() const { return n_; }
+
+				// data holds N reals on entry, and the N/2+1 non-redundant bins on exit.
+				// There must be room for 2 * (N/2+1) reals
+				void fft(T *data) const
+				{
+					if (n_ % 2 == 0) {
+						forward_->execute(data);
+						rfft_split(data, static_cast<unsigned>(n_), coeffs_.data());
+					}
+					else {
+						thread_local std::vector<complex> scratch;
+						scratch.assign(data, data + n_);
+						forward_->execute(reinterpret_cast<T *>(scratch.data()));
+						std::copy(scratch.begin(), scratch.begin() + n_ / 2 + 1, reinterpret_cast<complex *>(data));
+					}
+				}
+
+				// spectrum holds the N/2+1 non-redundant bins, data receives N reals, scaled so that ifft(fft(x)) == x
+				void ifft(const T *spectrum, T *data) const
+				{
+					if (n_ % 2 == 0) {
+						rfft_merge(spectrum, data, static_cast<unsigned>(n_), coeffs_.data());
+						inverse_->execute(data);
+					}
+					else {
+						// rebuild the full, hermitian, spectrum
+						thread_local std::vector<complex> scratch;
+						scratch.resize(n_);
+						const complex *bins = reinterpret_cast<const complex *>(spectrum);
+						for (size_t k = 0; k <= n_ / 2; ++k)
+							scratch[k] = bins[k];
+						for (size_t k = n_ / 2 + 1; k < n_; ++k)
+							scratch[k] = std::conj(bins[n_ - k]);
+						inverse_->execute(reinterpret_cast<T *>(scratch.data()));
+						for (size_t i = 0; i < n_; ++i)
+							data[i] = scratch[i].real();
+					}
+				}
+
+				explicit rfft_plan(size_t n) : n_(n)
+				{
+					if (n < 3)
+						throw eng_ex(format_message("No real FFT plan for size %zd.", n));
+					auto& cache = fft_plan_cache::get();
+					if (n % 2 == 0) {
+						forward_ = cache.plan<T>(n / 2, fft_direction::forward);
+						inverse_ = cache.plan<T>(n / 2, fft_direction::inverse);
+						coeffs_.resize(n);
+						fft_tables::fill_twiddles<T, 1>(coeffs_.data(), static_cast<unsigned>(n));
+					}
+					else {
+						forward_ = cache.plan<T>(n, fft_direction::forward);
+						inverse_ = cache.plan<T>(n, fft_direction::inverse);
+					}
+				}
+			};
+
+			////// fixed_fft
+			// complex fft of a compile-time size: the GFFT specialization for powers of two, otherwise the shared run-time plan
+
+			template<size_t N>constexpr bool fft_is_pow2 = N >= 2 && (N & (N - 1)) == 0;
+
+			template<size_t N, typename T, fft_direction DIR, bool POW2 = fft_is_pow2<N>>class fixed_fft
+			{
+				std::shared_ptr<const fft_plan<T>> plan_ = fft_plan_cache::get().plan<T>(N, DIR);
+
+			public:
+				void execute(T *data) const { plan_->execute(data); }
+			};
+
+			template<size_t N, typename T, fft_direction DIR>class fixed_fft<N, T, DIR, true>
+			{
+			public:
+				void execute(T *data) const { fft_plans::gfft_plan<N, T, DIR>().execute(data); }
+			};
+
+			////// fixed_rfft
+			// real fft of a compile-time size: GRFFT for powers of two, otherwise the run-time rfft_plan
+
+			template<size_t N, typename T, bool POW2 = fft_is_pow2<N> && N >= 4>class fixed_rfft
+			{
+				rfft_plan<T> plan_ = rfft_plan<T>(N);
+
+			public:
+				void fft(T *data) const { plan_.fft(data); }
+				void ifft(const T *spectrum, T *data) const { plan_.ifft(spectrum, data); }
+			};
+
+			template<size_t N, typename T>class fixed_rfft<N, T, true>
+			{
+				mutable GRFFT<N, T> grfft;
+
+			public:
+				void fft(T *data) const { grfft.fft(data); }
+				void ifft(const T *spectrum, T *data) const { grfft.ifft(spectrum, data); }
+			};
+
+		} // proc
+	} // eng
+} // sel
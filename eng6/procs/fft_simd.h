@@ -0,0 +1,99 @@
+#pragma once
+/*
+    Vectorized butterfly kernels for GFFT
+
+    The radix-2 and radix-4 kernels in fft_simd_kernels.h (and the Stockham passes of the mixed-radix plans) are compiled
+    once for each instruction set of simd.h, on its vector types, and dispatched at runtime in the same way
+    (see simd::force_isa() to override it).
+*/
+#include <utility>
+#include "simd.h"
+
+namespace fft_simd {
+
+    namespace scalar {
+        using simd::scalar::V;
+#include "fft_simd_kernels.h"
+    }
+
+#if defined(SEL_SIMD_X86)
+SEL_SIMD_TARGET_AVX2_BEGIN
+    namespace avx2 {
+        using simd::avx2::V;
+#include "fft_simd_kernels.h"
+    }
+SEL_SIMD_TARGET_END
+
+SEL_SIMD_AVX512_WARNINGS_BEGIN
+SEL_SIMD_TARGET_AVX512_BEGIN
+    namespace avx512 {
+        using simd::avx512::V;
+#include "fft_simd_kernels.h"
+    }
+SEL_SIMD_TARGET_END
+SEL_SIMD_AVX512_WARNINGS_END
+#endif
+
+    ////// kernels
+    // Runtime dispatch to the widest kernel that the CPU supports, and that the transform size can use
+
+    template<typename T, int SIGN>struct kernels {
+
+        template<bool SCALE = false>static void radix2(T *data, unsigned n, const T *w, T scale = 1) {
+#if defined(SEL_SIMD_X86)
+            const auto i = simd::active_isa();
+            if (i == simd::isa::avx512 && n % simd::avx512::V<T>::width == 0)
+                return avx512::radix2<T, SIGN, SCALE>(data, n, w, scale);
+            if (i != simd::isa::scalar && n % simd::avx2::V<T>::width == 0)
+                return avx2::radix2<T, SIGN, SCALE>(data, n, w, scale);
+#endif
+            scalar::radix2<T, SIGN, SCALE>(data, n, w, scale);
+        }
+
+        template<bool SCALE = false>static void radix4(T *data, unsigned q, const T *w1, const T *w2, T scale = 1) {
+#if defined(SEL_SIMD_X86)
+            const auto i = simd::active_isa();
+            if (i == simd::isa::avx512 && q % simd::avx512::V<T>::width == 0)
+                return avx512::radix4<T, SIGN, SCALE>(data, q, w1, w2, scale);
+            if (i != simd::isa::scalar && q % simd::avx2::V<T>::width == 0)
+                return avx2::radix4<T, SIGN, SCALE>(data, q, w1, w2, scale);
+#endif
+            scalar::radix4<T, SIGN, SCALE>(data, q, w1, w2, scale);
+        }
+
+        static void radix2_soa(T *re, T *im, unsigned n, unsigned K, const T *w) {
+#if defined(SEL_SIMD_X86)
+            const auto i = simd::active_isa();
+            if (i == simd::isa::avx512 && K >= 2 * simd::avx512::V<T>::width)
+                return avx512::radix2_soa<T, SIGN>(re, im, n, K, w);
+            if (i != simd::isa::scalar && K >= 2 * simd::avx2::V<T>::width)
+                return avx2::radix2_soa<T, SIGN>(re, im, n, K, w);
+#endif
+            scalar::radix2_soa<T, SIGN>(re, im, n, K, w);
+        }
+
+        static void radix4_soa(T *re, T *im, unsigned q, unsigned K, const T *w1, const T *w2) {
+#if defined(SEL_SIMD_X86)
+            const auto i = simd::active_isa();
+            if (i == simd::isa::avx512 && K >= 2 * simd::avx512::V<T>::width)
+                return avx512::radix4_soa<T, SIGN>(re, im, q, K, w1, w2);
+            if (i != simd::isa::scalar && K >= 2 * simd::avx2::V<T>::width)
+                return avx2::radix4_soa<T, SIGN>(re, im, q, K, w1, w2);
+#endif
+            scalar::radix4_soa<T, SIGN>(re, im, q, K, w1, w2);
+        }
+
+        // one radix-P Stockham pass of m butterflies (see fft_simd_kernels.h)
+        template<unsigned P>static void stockham(const T *x, T *y, unsigned m, unsigned stride, const T *w) {
+#if defined(SEL_SIMD_X86)
+            const auto i = simd::active_isa();
+            if (i == simd::isa::avx512 && (stride == 1 || stride % simd::avx512::V<T>::width == 0))
+                return avx512::stockham<T, SIGN, P>(x, y, m, stride, w);
+            if (i != simd::isa::scalar && (stride == 1 || stride % simd::avx2::V<T>::width == 0))
+                return avx2::stockham<T, SIGN, P>(x, y, m, stride, w);
+#endif
+            scalar::stockham<T, SIGN, P>(x, y, m, stride, w);
+        }
+    };
+
+} // fft_simd
@@ -0,0 +1,315 @@
+// NOTE: No include guard.  This file is included by fft_simd.h once per instruction set,
+// inside a namespace which brings in the vector type V<T> of simd.h, with its complex operations.
+// The structure-of-arrays kernels use V<T>::type as a vector of 2 * V<T>::width reals.
+
+////// radix2
+// One Danielson-Lanczos stage: n butterflies combining the two halves of data (n complex values each)
+// twiddles w holds n complex coefficients.  n must be a multiple of V<T>::width
+// If SCALE, the outputs are multiplied by scale (used to fold the 1/N of an inverse transform into its last pass)
+
+template<typename T, int SIGN, bool SCALE = false>
+void radix2(T *data, unsigned n, const T *w, T scale = 1) {
+    using v = V<T>;
+    T *dataN = data + 2 * n;
+    for (unsigned k = 0; k < 2 * n; k += 2 * v::width) {
+        auto a = v::load(data + k);
+        auto t = v::cmul(v::load(dataN + k), v::load(w + k));
+        if constexpr (SCALE) {
+            a = v::mul(a, scale);
+            t = v::mul(t, scale);
+        }
+        v::store(data + k, v::add(a, t));
+        v::store(dataN + k, v::sub(a, t));
+    }
+}
+
+////// radix4
+// Two Danielson-Lanczos stages fused: combines the four quarters of data (q complex values each) in one pass.
+// w1 holds the q first twiddles of the N-point stage, w2 the q twiddles of the N/2-point stage.
+// q must be a multiple of V<T>::width.  If SCALE, the outputs are multiplied by scale
+
+template<typename T, int SIGN, bool SCALE = false>
+void radix4(T *data, unsigned q, const T *w1, const T *w2, T scale = 1) {
+    using v = V<T>;
+    T *d0 = data;
+    T *d1 = data + 2 * q;
+    T *d2 = data + 4 * q;
+    T *d3 = data + 6 * q;
+    for (unsigned k = 0; k < 2 * q; k += 2 * v::width) {
+        auto q0 = v::load(d0 + k);
+        auto q1 = v::load(d1 + k);
+        auto q2 = v::load(d2 + k);
+        auto q3 = v::load(d3 + k);
+        const auto t2 = v::load(w2 + k);
+        if constexpr (SCALE) {
+            q0 = v::mul(q0, scale);
+            q1 = v::mul(q1, scale);
+            q2 = v::mul(q2, scale);
+            q3 = v::mul(q3, scale);
+        }
+
+        // N/2-point stage, on the even and odd halves
+        const auto a = v::cmul(q1, t2);
+        const auto b = v::cmul(q3, t2);
+        const auto e0 = v::add(q0, a);
+        const auto e1 = v::sub(q0, a);
+        const auto o0 = v::add(q2, b);
+        const auto o1 = v::sub(q2, b);
+
+        // N-point stage. The twiddle for bin k+N/4 is the twiddle for bin k rotated by -SIGN * i
+        const auto t1 = v::load(w1 + k);
+        const auto r0 = v::cmul(o0, t1);
+        const auto r1 = SIGN > 0 ? v::mul_negi(v::cmul(o1, t1)) : v::mul_i(v::cmul(o1, t1));
+
+        v::store(d0 + k, v::add(e0, r0));
+        v::store(d2 + k, v::sub(e0, r0));
+        v::store(d1 + k, v::add(e1, r1));
+        v::store(d3 + k, v::sub(e1, r1));
+    }
+}
+
+////// radix2_soa, radix4_soa
+// The radix2 and radix4 stages over K transforms at once, in structure-of-arrays layout:
+// element j of transform l is (re[j*K + l], im[j*K + l]), so each butterfly runs across all K transforms,
+// one twiddle factor (broadcast) per row.  Any K: lanes which don't fill a vector are done in scalar code
+
+template<typename T, int SIGN>
+void radix2_soa(T *re, T *im, unsigned n, unsigned K, const T *w) {
+    using v = V<T>;
+    constexpr unsigned L = 2 * v::width;
+    const unsigned KV = K - K % L;
+    for (unsigned j = 0; j < n; ++j) {
+        const T wr = w[2 * j];
+        const T wi = w[2 * j + 1];
+        T *ar = re + j * K;
+        T *ai = im + j * K;
+        T *br = re + (j + n) * K;
+        T *bi = im + (j + n) * K;
+
+        const auto vwr = v::splat(wr);
+        const auto vwi = v::splat(wi);
+        for (unsigned l = 0; l < KV; l += L) {
+            const auto xr = v::load(br + l);
+            const auto xi = v::load(bi + l);
+            const auto tr = v::sub(v::mulv(xr, vwr), v::mulv(xi, vwi));
+            const auto ti = v::add(v::mulv(xr, vwi), v::mulv(xi, vwr));
+            const auto yr = v::load(ar + l);
+            const auto yi = v::load(ai + l);
+            v::store(ar + l, v::add(yr, tr));
+            v::store(ai + l, v::add(yi, ti));
+            v::store(br + l, v::sub(yr, tr));
+            v::store(bi + l, v::sub(yi, ti));
+        }
+        for (unsigned l = KV; l < K; ++l) {
+            const T tr = br[l] * wr - bi[l] * wi;
+            const T ti = br[l] * wi + bi[l] * wr;
+            br[l] = ar[l] - tr;
+            bi[l] = ai[l] - ti;
+            ar[l] += tr;
+            ai[l] += ti;
+        }
+    }
+}
+
+template<typename T, int SIGN>
+void radix4_soa(T *re, T *im, unsigned q, unsigned K, const T *w1, const T *w2) {
+    using v = V<T>;
+    constexpr unsigned L = 2 * v::width;
+    const unsigned KV = K - K % L;
+    for (unsigned j = 0; j < q; ++j) {
+        const T w1r = w1[2 * j], w1i = w1[2 * j + 1];
+        const T w2r = w2[2 * j], w2i = w2[2 * j + 1];
+        T *r0 = re + j * K, *i0 = im + j * K;
+        T *r1 = r0 + q * K, *i1 = i0 + q * K;
+        T *r2 = r1 + q * K, *i2 = i1 + q * K;
+        T *r3 = r2 + q * K, *i3 = i2 + q * K;
+
+        const auto v1r = v::splat(w1r), v1i = v::splat(w1i);
+        const auto v2r = v::splat(w2r), v2i = v::splat(w2i);
+        for (unsigned l = 0; l < KV; l += L) {
+            // N/2-point stage, on the even and odd halves
+            const auto q1r = v::load(r1 + l), q1i = v::load(i1 + l);
+            const auto q3r = v::load(r3 + l), q3i = v::load(i3 + l);
+            const auto ar = v::sub(v::mulv(q1r, v2r), v::mulv(q1i, v2i));
+            const auto ai = v::add(v::mulv(q1r, v2i), v::mulv(q1i, v2r));
+            const auto br = v::sub(v::mulv(q3r, v2r), v::mulv(q3i, v2i));
+            const auto bi = v::add(v::mulv(q3r, v2i), v::mulv(q3i, v2r));
+            const auto q0r = v::load(r0 + l), q0i = v::load(i0 + l);
+            const auto q2r = v::load(r2 + l), q2i = v::load(i2 + l);
+            const auto e0r = v::add(q0r, ar), e0i = v::add(q0i, ai);
+            const auto e1r = v::sub(q0r, ar), e1i = v::sub(q0i, ai);
+            const auto o0r = v::add(q2r, br), o0i = v::add(q2i, bi);
+            const auto o1r = v::sub(q2r, br), o1i = v::sub(q2i, bi);
+
+            // N-point stage. The twiddle for row j+N/4 is the twiddle for row j rotated by -SIGN * i
+            const auto s0r = v::sub(v::mulv(o0r, v1r), v::mulv(o0i, v1i));
+            const auto s0i = v::add(v::mulv(o0r, v1i), v::mulv(o0i, v1r));
+            const auto tr = v::sub(v::mulv(o1r, v1r), v::mulv(o1i, v1i));
+            const auto ti = v::add(v::mulv(o1r, v1i), v::mulv(o1i, v1r));
+            // -i * t = (ti, -tr), i * t = (-ti, tr)
+            const auto zero = v::splat(0);
+            const auto s1r = SIGN > 0 ? ti : v::sub(zero, ti);
+            const auto s1i = SIGN > 0 ? v::sub(zero, tr) : tr;
+
+            v::store(r0 + l, v::add(e0r, s0r));
+            v::store(i0 + l, v::add(e0i, s0i));
+            v::store(r2 + l, v::sub(e0r, s0r));
+            v::store(i2 + l, v::sub(e0i, s0i));
+            v::store(r1 + l, v::add(e1r, s1r));
+            v::store(i1 + l, v::add(e1i, s1i));
+            v::store(r3 + l, v::sub(e1r, s1r));
+            v::store(i3 + l, v::sub(e1i, s1i));
+        }
+        for (unsigned l = KV; l < K; ++l) {
+            const T ar = r1[l] * w2r - i1[l] * w2i, ai = r1[l] * w2i + i1[l] * w2r;
+            const T br = r3[l] * w2r - i3[l] * w2i, bi = r3[l] * w2i + i3[l] * w2r;
+            const T e0r = r0[l] + ar, e0i = i0[l] + ai;
+            const T e1r = r0[l] - ar, e1i = i0[l] - ai;
+            const T o0r = r2[l] + br, o0i = i2[l] + bi;
+            const T o1r = r2[l] - br, o1i = i2[l] - bi;
+            const T s0r = o0r * w1r - o0i * w1i, s0i = o0r * w1i + o0i * w1r;
+            const T tr = o1r * w1r - o1i * w1i, ti = o1r * w1i + o1i * w1r;
+            const T s1r = SIGN > 0 ? ti : -ti;
+            const T s1i = SIGN > 0 ? -tr : tr;
+            r0[l] = e0r + s0r; i0[l] = e0i + s0i;
+            r2[l] = e0r - s0r; i2[l] = e0i - s0i;
+            r1[l] = e1r + s1r; i1[l] = e1i + s1i;
+            r3[l] = e1r - s1r; i3[l] = e1i - s1i;
+        }
+    }
+}
+
+////// stockham
+// One radix-P pass (P = 2, 3, 4 or 5) of a Stockham autosort FFT, from x to y, for mixed-radix sizes.
+// For each q < m and s < stride, the butterfly on x[s + stride * (q + r * m)], r = 0..P-1, goes to y[s + stride * (P * q + u)],
+// u = 0..P-1, with output u multiplied by the twiddle at w[(u - 1) * m + q] (indices in complex values).
+// Vectorized across s if stride is a multiple of V<T>::width, else across q, which needs stride == 1
+
+// a[r] = x[r * step], and y[r * step] = a[r], for r in R.  Folded rather than looped, so that the a[] stay in registers
+template<typename v, typename T, unsigned... R>
+void stockham_load(typename v::type *a, const T *x, size_t step, std::integer_sequence<unsigned, R...>) {
+    ((a[R] = v::load(x + step * R)), ...);
+}
+
+template<typename v, typename T, unsigned... R>
+void stockham_store(T *y, size_t step, const typename v::type *a, std::integer_sequence<unsigned, R...>) {
+    (v::store(y + step * R, a[R]), ...);
+}
+
+// y[l * P + u] = out[u][l], l < V<T>::width, u in U (all indices in complex values)
+template<typename v, typename T, unsigned... U>
+void stockham_transpose(T *y, const T (*out)[2 * v::width], std::integer_sequence<unsigned, U...>) {
+    constexpr unsigned P = sizeof...(U);
+    for (unsigned l = 0; l < v::width; ++l)
+        ((y[2 * (P * l + U)] = out[U][2 * l], y[2 * (P * l + U) + 1] = out[U][2 * l + 1]), ...);
+}
+
+// a[u] *= t[u], u = 1 .. P-1 (R = u - 1)
+template<typename v, unsigned... R>
+void stockham_twiddle(typename v::type *a, const typename v::type *t, std::integer_sequence<unsigned, R...>) {
+    ((a[R + 1] = v::cmul(a[R + 1], t[R + 1])), ...);
+}
+
+// multiply by -SIGN * i
+template<int SIGN, typename v>
+typename v::type stockham_rotate(typename v::type a) {
+    return SIGN > 0 ? v::mul_negi(a) : v::mul_i(a);
+}
+
+// radix-P butterfly, in place, on a[0] .. a[P-1]
+template<typename T, int SIGN, unsigned P, typename v>
+void stockham_butterfly(typename v::type *a) {
+    if constexpr (P == 2) {
+        const auto a0 = a[0];
+        a[0] = v::add(a0, a[1]);
+        a[1] = v::sub(a0, a[1]);
+    }
+    else if constexpr (P == 3) {
+        constexpr T c = T(-0.5);
+        constexpr T s = T(0.86602540378443864676);     // sin(2pi/3)
+        const auto t = v::add(a[1], a[2]);
+        const auto d = v::mul(stockham_rotate<SIGN, v>(v::sub(a[1], a[2])), s);
+        const auto m = v::add(a[0], v::mul(t, c));
+        a[0] = v::add(a[0], t);
+        a[1] = v::add(m, d);
+        a[2] = v::sub(m, d);
+    }
+    else if constexpr (P == 4) {
+        const auto t0 = v::add(a[0], a[2]);
+        const auto t1 = v::sub(a[0], a[2]);
+        const auto t2 = v::add(a[1], a[3]);
+        const auto t3 = stockham_rotate<SIGN, v>(v::sub(a[1], a[3]));
+        a[0] = v::add(t0, t2);
+        a[1] = v::add(t1, t3);
+        a[2] = v::sub(t0, t2);
+        a[3] = v::sub(t1, t3);
+    }
+    else {
+        static_assert(P == 5, "stockham: unsupported radix");
+        constexpr T c1 = T(0.30901699437494742410);    // cos(2pi/5)
+        constexpr T c2 = T(-0.80901699437494742410);   // cos(4pi/5)
+        constexpr T s1 = T(0.95105651629515357212);    // sin(2pi/5)
+        constexpr T s2 = T(0.58778525229247312917);    // sin(4pi/5)
+        const auto t1 = v::add(a[1], a[4]);
+        const auto d1 = v::sub(a[1], a[4]);
+        const auto t2 = v::add(a[2], a[3]);
+        const auto d2 = v::sub(a[2], a[3]);
+        const auto m1 = v::add(a[0], v::add(v::mul(t1, c1), v::mul(t2, c2)));
+        const auto m2 = v::add(a[0], v::add(v::mul(t1, c2), v::mul(t2, c1)));
+        const auto r1 = stockham_rotate<SIGN, v>(v::add(v::mul(d1, s1), v::mul(d2, s2)));
+        const auto r2 = stockham_rotate<SIGN, v>(v::sub(v::mul(d1, s2), v::mul(d2, s1)));
+        a[0] = v::add(a[0], v::add(t1, t2));
+        a[1] = v::add(m1, r1);
+        a[4] = v::sub(m1, r1);
+        a[2] = v::add(m2, r2);
+        a[3] = v::sub(m2, r2);
+    }
+}
+
+// each butterfly on V<T>::width consecutive values of s at a time, with one (broadcast) twiddle per output
+template<typename T, int SIGN, unsigned P, typename v>
+void stockham_across_s(const T *x, T *y, unsigned m, unsigned stride, const T *w) {
+    typename v::type a[P];
+    typename v::type t[P];
+    const size_t xr = size_t(2) * stride * m;  // from one butterfly input to the next
+    const size_t yu = size_t(2) * stride;      // and output
+    for (unsigned q = 0; q < m; ++q) {
+        for (unsigned u = 1; u < P; ++u)
+            t[u] = v::broadcast(w + 2 * (size_t(u - 1) * m + q));
+        const T *xq = x + yu * q;
+        T *yq = y + yu * P * q;
+        for (size_t s = 0; s < yu; s += 2 * v::width) {
+            stockham_load<v>(a, xq + s, xr, std::make_integer_sequence<unsigned, P>());
+            stockham_butterfly<T, SIGN, P, v>(a);
+            stockham_twiddle<v>(a, t, std::make_integer_sequence<unsigned, P - 1>());
+            stockham_store<v>(yq + s, yu, a, std::make_integer_sequence<unsigned, P>());
+        }
+    }
+}
+
+// stride 1:  butterflies q_begin .. q_end-1, V<T>::width at a time (q_end - q_begin must be a multiple of it).
+// The P outputs of a butterfly are adjacent in y, so the vectors are transposed on the way out
+template<typename T, int SIGN, unsigned P, typename v>
+void stockham_across_q(const T *x, T *y, unsigned m, unsigned q_begin, unsigned q_end, const T *w) {
+    typename v::type a[P];
+    typename v::type t[P];
+    T out[P][2 * v::width];
+    for (unsigned q = q_begin; q < q_end; q += v::width) {
+        stockham_load<v>(a, x + 2 * q, size_t(2) * m, std::make_integer_sequence<unsigned, P>());
+        stockham_load<v>(t + 1, w + 2 * q, size_t(2) * m, std::make_integer_sequence<unsigned, P - 1>());
+        stockham_butterfly<T, SIGN, P, v>(a);
+        stockham_twiddle<v>(a, t, std::make_integer_sequence<unsigned, P - 1>());
+        stockham_store<v>(out[0], 2 * v::width, a, std::make_integer_sequence<unsigned, P>());
+        stockham_transpose<v>(y + 2 * P * q, out, std::make_integer_sequence<unsigned, P>());
+    }
+}
+
+template<typename T, int SIGN, unsigned P>
+void stockham(const T *x, T *y, unsigned m, unsigned stride, const T *w) {
+    using v = V<T>;
+    if (stride % v::width == 0)
+        return stockham_across_s<T, SIGN, P, v>(x, y, m, stride, w);
+    const unsigned mv = m - m % v::width;
+    stockham_across_q<T, SIGN, P, v>(x, y, m, 0, mv, w);
+    stockham_across_q<T, SIGN, P, simd::scalar::V<T>>(x, y, m, mv, m, w);
+}
@@ -3,6 +3,7 @@
 #include "fft.h"
 #include "rand.h"
 #include <iostream>
+#include <chrono>
 #include "../unit_test.h"
 
 SEL_UNIT_TEST(fft)
@@ -13,10 +14,34 @@ struct ut_traits
 };
 using fft = sel::eng6::proc::fft_t<ut_traits>;
 using ifft = sel::eng6::proc::ifft<ut_traits>;
+using fftr = sel::eng6::proc::fftr_t<ut_traits>;
+using ifftr = sel::eng6::proc::ifftr_t<ut_traits>;
 
 
 static constexpr size_t  SZ = ut_traits::input_frame_size;
 
+// 25ms frames at 16kHz: mixed-radix (4*4*5*5)
+struct ut_traits_400
+{
+	static constexpr size_t input_frame_size = 400;
+};
+// zero-padded equivalent
+struct ut_traits_512
+{
+	static constexpr size_t input_frame_size = 512;
+};
+
+// frames per second through proc, which must already be connected and frozen
+template<class PROC>double throughput(PROC& proc)
+{
+	constexpr size_t NFRAMES = 20000;
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < NFRAMES; ++i)
+		proc.process();
+	const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	return NFRAMES / elapsed.count();
+}
+
 void run() {
 
 	sel::eng6::proc::rand<SZ> rng;
@@ -53,7 +78,193 @@ void run() {
 	for (size_t i = 0; i < SZ; ++i)
 		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(my_ifft_result[i].real(), rng.out[i]);
 
+	fftr fftr1;
+	rng.ConnectTo(fftr1);
+	fftr1.freeze();
+	fftr1.process();
+
+	csamp_t* my_fftr_result = (csamp_t*)fftr1.out;
 
+	// the real fft should give the non-redundant half of the full fft
+	SEL_UNIT_TEST_ITEM("np.fft.rfft");
+	auto py_np_fft_rfft = python::get().np.attr("fft").attr("rfft");
+	py::array_t<csamp_t> rfft_py = py_np_fft_rfft(rand_py);
+	auto rfft_py_vec = python::make_vector_from_1d_numpy_array(rfft_py);
+	for (size_t i = 0; i < SZ / 2 + 1; ++i) {
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(rfft_py_vec[i].real(), my_fftr_result[i].real());
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(rfft_py_vec[i].imag(), my_fftr_result[i].imag());
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(my_fft_result[i].real(), my_fftr_result[i].real());
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(my_fft_result[i].imag(), my_fftr_result[i].imag());
+	}
+
+	ifftr ifftr1;
+	fftr1.ConnectTo(ifftr1);
+	ifftr1.freeze();
+	ifftr1.process();
+
+	SEL_UNIT_TEST_ITEM("invert (ifftr)");
+	for (size_t i = 0; i < SZ; ++i)
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(ifftr1.out[i], rng.out[i]);
+
+	// the vectorized butterflies (if the cpu supports them) should agree with the scalar ones
+	SEL_UNIT_TEST_ITEM("simd vs scalar");
+	const auto detected_isa = simd::detect_isa();
+	std::cout << "fft kernels: " << simd::isa_name(detected_isa) << std::endl;
+	simd::force_isa(simd::isa::scalar);
+	fft1.process();
+	simd::force_isa(detected_isa);
+	for (size_t i = 0; i < SZ; ++i) {
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fft_py_vec[i].real(), my_fft_result[i].real());
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fft_py_vec[i].imag(), my_fft_result[i].imag());
+	}
+
+	// run-time sized fft should match the compile-time one, and share its plan with other instances of the same size
+	SEL_UNIT_TEST_ITEM("fft_n");
+	sel::params fft_n_params = { "size", "1024" };
+	sel::eng6::proc::fft_n fft_n1(fft_n_params);
+	sel::eng6::proc::fft_n fft_n2;
+	rng.ConnectTo(fft_n1);
+	rng.ConnectTo(fft_n2);
+	fft_n1.freeze();
+	fft_n2.freeze();
+	fft_n1.process();
+	SEL_UNIT_TEST_ASSERT(fft_n1.plan_ == fft_n2.plan_);
+	for (size_t i = 0; i < 2 * SZ; ++i)
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fft_n1.out[i], fft1.out[i]);
+
+	SEL_UNIT_TEST_ITEM("invert (ifft_n)");
+	sel::eng6::proc::ifft_n ifft_n1;
+	fft_n1.ConnectTo(ifft_n1);
+	ifft_n1.freeze();
+	ifft_n1.process();
+	for (size_t i = 0; i < SZ; ++i) {
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(ifft_n1.out[2 * i], rng.out[i]);
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(ifft_n1.out[2 * i + 1], 0.0);
+	}
+
+	// batched fft: each frame should match fft_t.  5 frames: vector lanes plus a scalar tail
+	SEL_UNIT_TEST_ITEM("fft_batch");
+	{
+		constexpr size_t K = 5;
+		sel::eng6::proc::rand<K * SZ> rng_k;
+		sel::eng6::proc::fft_batch_t<ut_traits, K> fft_k;
+		rng_k.ConnectTo(fft_k);
+		rng_k.freeze();
+		fft_k.freeze();
+		rng_k.process();
+		fft_k.process();
+		for (size_t k = 0; k < K; ++k) {
+			sel::eng6::Const frame(rng_k.out + k * SZ, rng_k.out + (k + 1) * SZ);
+			fft fft_frame;
+			frame.ConnectTo(fft_frame);
+			fft_frame.freeze();
+			fft_frame.process();
+			for (size_t i = 0; i < 2 * SZ; ++i)
+				SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fft_k.out[2 * k * SZ + i], fft_frame.out[i]);
+		}
+	}
+
+	// non power of two sizes, against numpy
+	{
+		constexpr size_t SZ400 = ut_traits_400::input_frame_size;
+		sel::eng6::proc::rand<SZ400> rng400;
+		sel::eng6::proc::fft_t<ut_traits_400> fft400;
+		sel::eng6::proc::fftr_t<ut_traits_400> fftr400;
+		sel::eng6::proc::ifftr_t<ut_traits_400> ifftr400;
+		rng400.ConnectTo(fft400);
+		rng400.ConnectTo(fftr400);
+		fftr400.ConnectTo(ifftr400);
+		rng400.freeze();
+		fft400.freeze();
+		fftr400.freeze();
+		ifftr400.freeze();
+		rng400.process();
+		fft400.process();
+		fftr400.process();
+		ifftr400.process();
+
+		SEL_UNIT_TEST_ITEM("np.fft.fft (400)");
+		py::array_t<double> rand400_py(SZ400, rng400.out);
+		auto fft400_py_vec = python::make_vector_from_1d_numpy_array(py::array_t<csamp_t>(py_np_fft_fft(rand400_py)));
+		const csamp_t *fft400_result = reinterpret_cast<const csamp_t *>(fft400.out);
+		const csamp_t *fftr400_result = reinterpret_cast<const csamp_t *>(fftr400.out);
+		for (size_t i = 0; i < SZ400; ++i) {
+			SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fft400_py_vec[i].real(), fft400_result[i].real());
+			SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fft400_py_vec[i].imag(), fft400_result[i].imag());
+		}
+
+		SEL_UNIT_TEST_ITEM("np.fft.rfft (400)");
+		for (size_t i = 0; i < SZ400 / 2 + 1; ++i) {
+			SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fft400_py_vec[i].real(), fftr400_result[i].real());
+			SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fft400_py_vec[i].imag(), fftr400_result[i].imag());
+		}
+
+		SEL_UNIT_TEST_ITEM("invert (ifftr 400)");
+		for (size_t i = 0; i < SZ400; ++i)
+			SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(ifftr400.out[i], rng400.out[i]);
+
+		// the vectorized Stockham passes should agree with the scalar ones
+		SEL_UNIT_TEST_ITEM("simd vs scalar (400)");
+		simd::force_isa(simd::isa::scalar);
+		fft400.process();
+		simd::force_isa(detected_isa);
+		for (size_t i = 0; i < SZ400; ++i) {
+			SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fft400_py_vec[i].real(), fft400_result[i].real());
+			SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fft400_py_vec[i].imag(), fft400_result[i].imag());
+		}
+
+		// 398 = 2 * 199 needs Bluestein
+		SEL_UNIT_TEST_ITEM("np.fft.fft (Bluestein, 398)");
+		sel::eng6::proc::fft_n fft398(398);
+		sel::eng6::proc::ifft_n ifft398;
+		sel::eng6::Const in398(rng400.out, rng400.out + 398);
+		in398.ConnectTo(fft398);
+		fft398.ConnectTo(ifft398);
+		fft398.freeze();
+		ifft398.freeze();
+		fft398.process();
+		ifft398.process();
+		py::array_t<double> rand398_py(398, rng400.out);
+		auto fft398_py_vec = python::make_vector_from_1d_numpy_array(py::array_t<csamp_t>(py_np_fft_fft(rand398_py)));
+		const csamp_t *fft398_result = reinterpret_cast<const csamp_t *>(fft398.out);
+		for (size_t i = 0; i < 398; ++i) {
+			SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fft398_py_vec[i].real(), fft398_result[i].real());
+			SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(fft398_py_vec[i].imag(), fft398_result[i].imag());
+			SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(ifft398.out[2 * i], rng400.out[i]);
+		}
+
+		// throughput, against zero-padding to 512
+		sel::eng6::proc::fft_t<ut_traits_512> fft512;
+		sel::eng6::proc::fftr_t<ut_traits_512> fftr512;
+		sel::eng6::Const in512(std::vector<samp_t>(512, 0.0));
+		in512.ConnectTo(fft512);
+		in512.ConnectTo(fftr512);
+		fft512.freeze();
+		fftr512.freeze();
+		std::cout << "\n  fft frames/s:  400: " << throughput(fft400) << ", 512: " << throughput(fft512);
+		std::cout << "\n  fftr frames/s: 400: " << throughput(fftr400) << ", 512: " << throughput(fftr512) << std::endl;
+	}
+
+	// sizes outside the precompiled range use the generic plan
+	SEL_UNIT_TEST_ITEM("generic plan");
+	for (size_t n = 2; n <= 65536; n *= 2) {
+		auto fwd = sel::eng6::proc::fft_plan_cache::get().plan<samp_t>(n, sel::eng6::proc::fft_direction::forward);
+		auto inv = sel::eng6::proc::fft_plan_cache::get().plan<samp_t>(n, sel::eng6::proc::fft_direction::inverse);
+		SEL_UNIT_TEST_ASSERT(fwd->size() == n);
+		std::vector<samp_t> x(2 * n);
+		for (size_t i = 0; i < 2 * n; ++i)
+			x[i] = rng.out[i % SZ];
+		auto y = x;
+		fwd->execute(y.data());
+		// dc bin is the sum
+		samp_t sum_re = 0;
+		for (size_t i = 0; i < n; ++i)
+			sum_re += x[2 * i];
+		SEL_UNIT_TEST_EQUAL_THRESH(y[0], sum_re, 1e-9 * n);
+		inv->execute(y.data());
+		for (size_t i = 0; i < 2 * n; ++i)
+			SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(y[i], x[i]);
+	}
 
 }
 
@@ -2,6 +2,7 @@
 #include "../processor.h"
 #include "../idx.h"
 #include <vector>
+#include <algorithm>
 
 
 
@@ -17,6 +18,7 @@ namespace sel {
 				std::vector<samp_t> coeffs_;
 				std::vector<samp_t> buf_;
 				modulo_ptr<samp_t, Sz> buf_ptr_;
+				std::vector<samp_t> block_buf_;	// history and input, in time order, for process_block()
 
 			public:
 				explicit fir_filt() : sz(0) {}
@@ -52,6 +54,36 @@ namespace sel {
 					this->out[0] = output;
 
 				}	
+
+				bool block_capable() const final { return true; }
+
+				// n samples at once:  unroll the history into a linear buffer after the last sz-1 samples,
+				// then accumulate one coefficient at a time over the whole block (vectorizable, and summed in the same order as process())
+				void process_block(size_t n) final
+				{
+					if (block_buf_.size() < sz - 1 + n)
+						block_buf_.resize(sz - 1 + n);
+					samp_t *x = block_buf_.data();
+
+					// buf_ptr_ is at the oldest sample, which the next input replaces
+					++buf_ptr_;
+					for (size_t j = 0; j < sz - 1; ++j)
+						x[j] = *buf_ptr_++;
+					std::copy(this->in, this->in + n, x + sz - 1);
+
+					samp_t *out = this->out;
+					std::fill(out, out + n, 0.0);
+					for (size_t i = 0; i < sz; ++i) {
+						const samp_t coeff = coeffs_[i];
+						const samp_t *xi = x + i;
+						for (size_t k = 0; k < n; ++k)
+							out[k] += coeff * xi[k];
+					}
+
+					// the last sz samples back to the history, oldest at buf_ptr_
+					for (size_t j = 0; j < sz; ++j)
+						*buf_ptr_++ = x[n - 1 + j];
+				}
 			};
 
 		} // proc
@@ -59,12 +91,17 @@ namespace sel {
 } // sel
 #if (defined(COMPILE_UNIT_TESTS) || defined(UNIT_TEST_FIR_FILT))
 #include "rand.h"
+#include "ewma.h"
+#include "iir_filt.h"
+#include "compound_processor.h"
 #include "../unit_test.h"
 
 SEL_UNIT_TEST(fir_filt)
 struct ut_traits
 {
 	static constexpr size_t signal_length = 10;
+	static constexpr size_t block_signal_length = 1000;
+	static constexpr size_t block = 64;
 };
 std::array<samp_t, ut_traits::signal_length> matlab_results = { {
 -0.0567770431402061,
@@ -95,7 +132,78 @@ void run()
 
 	}
 
-	
+	// rand -> fir -> ewma -> iir -> capture, scheduled for block_signal_length ticks, in blocks of up to max_block
+	struct capture : sel::eng6::Processor1A0<1>
+	{
+		std::vector<samp_t> values;
+		size_t calls = 0;
+		void process() final { values.push_back(in[0]); ++calls; }
+		bool block_capable() const final { return true; }
+		void process_block(size_t n) final { values.insert(values.end(), in, in + n); ++calls; }
+	};
+	struct chain
+	{
+		sel::eng6::proc::rand<1> rng;
+		sel::eng6::proc::fir_filt<4> filt = { -0.0696887105265845,	0.366902203216131,	0.366902203216131,	-0.0696887105265845 };
+		sel::eng6::proc::ewma<16000> smooth = sel::eng6::proc::ewma<16000>(0.1);
+		sel::eng6::proc::lp_filter_6dB<1, 1000, 16000> lp;
+		capture sink;
+		sel::eng6::proc::compound_processor fiber;
+		sel::eng6::semaphore trigger;
+		sel::eng6::schedule sched;
+
+		explicit chain(size_t max_block) : sched(&trigger, fiber, max_block)
+		{
+			fiber.connect_procs(rng, filt);
+			fiber.connect_procs(filt, smooth);
+			fiber.connect_procs(smooth, lp);
+			fiber.connect_procs(lp, sink);
+			sched.init();
+			sched.invoke(ut_traits::block_signal_length);
+		}
+	};
+
+	SEL_UNIT_TEST_ITEM("process_block");
+	chain ticks(1), blocks(ut_traits::block);
+	SEL_UNIT_TEST_ASSERT(ticks.sched.block() == 1 && blocks.sched.block() == ut_traits::block);
+	SEL_UNIT_TEST_ASSERT(ticks.sink.calls == ut_traits::block_signal_length);
+	SEL_UNIT_TEST_ASSERT(blocks.sink.calls == (ut_traits::block_signal_length + ut_traits::block - 1) / ut_traits::block);
+	SEL_UNIT_TEST_ASSERT(ticks.trigger.rate().iters() == blocks.trigger.rate().iters());
+	SEL_UNIT_TEST_ASSERT(blocks.sink.values.size() == ut_traits::block_signal_length);
+	for (size_t i = 0; i < ut_traits::block_signal_length; ++i)
+		SEL_UNIT_TEST_EQUAL_THRESH(ticks.sink.values[i], blocks.sink.values[i], 1e-15);
+
+	// a fiber with a processor that can't run blocks runs one tick per call
+	SEL_UNIT_TEST_ITEM("process_block fallback");
+	{
+		sel::eng6::proc::rand<1> rng2;
+		struct tick_sink : sel::eng6::Processor1A0<1>
+		{
+			size_t calls = 0;
+			void process() final { ++calls; }
+		} sink2;
+		sel::eng6::proc::compound_processor fiber2;
+		fiber2.connect_procs(rng2, sink2);
+		sel::eng6::semaphore trigger2;
+		sel::eng6::schedule sched2(&trigger2, fiber2, ut_traits::block);
+		sched2.init();
+		sched2.invoke(ut_traits::block_signal_length);
+		SEL_UNIT_TEST_ASSERT(sched2.block() == 1);
+		SEL_UNIT_TEST_ASSERT(sink2.calls == ut_traits::block_signal_length);
+	}
+
+	SEL_UNIT_TEST_ITEM("frozen port frames");
+	{
+		sel::port_t<samp_t> port(4);
+		port.setframes(ut_traits::block);
+		port.freeze();
+		port.setframes(ut_traits::block);
+		bool threw = false;
+		try { port.setframes(ut_traits::block + 1); }
+		catch (sel::sp_ex_portwidth_frozen&) { threw = true; }
+		SEL_UNIT_TEST_ASSERT(threw);
+		SEL_UNIT_TEST_ASSERT(port.frames() == ut_traits::block && port.as_vector_ref().size() == 4 * ut_traits::block);
+	}
 }
 SEL_UNIT_TEST_END
 #endif
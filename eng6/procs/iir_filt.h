@@ -24,7 +24,33 @@ namespace sel {
 				if (a_[0] == 0.0)
 					throw eng_ex("IIR Filter: first denominator (a) coefficient cannot be zero.");
 				}
-					
+
+				// filter count consecutive samples
+				void filter_(const samp_t *in, samp_t *out, size_t count)
+				{
+					size_t j;
+
+                    for (size_t i = 0; i < count; ++i) {
+
+                        samp_t y = 0;
+
+                        w_[0] = in[i];				// current input sample
+
+                        for (j = 1; j < n_coeffs; ++j )	// input adder
+                            w_[0] -= a_[j] * w_[j];
+
+                        for (j = 0; j < n_coeffs ; ++j )	// output adder
+                            y += b_[j] * w_[j];
+
+                        // now i == sz
+                        for (--j; j != 0; --j )		// shift buf backwards
+                            w_[j] = w_[j - 1];
+
+                        out[i] =  y / a_[0];		// current output sample
+
+                    }
+
+				}
 				
 			public:
 
@@ -59,29 +85,15 @@ namespace sel {
 
 				void process() final 
 				{
-					size_t j;
-
-                    for (size_t i = 0; i < SZ; ++i) {
-
-                        samp_t y = 0;
-
-                        w_[0] = iir_filt<SZ>::in[i];				// current input sample
-
-                        for (j = 1; j < n_coeffs; ++j )	// input adder
-                            w_[0] -= a_[j] * w_[j];
-
-                        for (j = 0; j < n_coeffs ; ++j )	// output adder
-                            y += b_[j] * w_[j];
-
-                        // now i == sz
-                        for (--j; j != 0; --j )		// shift buf backwards
-                            w_[j] = w_[j - 1];
-
-                        iir_filt<SZ>::out[i] =  y / a_[0];		// current output sample
-
-                    }
-
+					filter_(this->in, this->out, SZ);
 				}	
+
+				// n frames are n * SZ consecutive samples
+				bool block_capable() const final { return true; }
+				void process_block(size_t n) final
+				{
+					filter_(this->in, this->out, n * SZ);
+				}
 			};
 
 			template<size_t SZ>struct preemphasis_filter : iir_filt<SZ>
@@ -37,6 +37,170 @@ namespace sel {
 				melspec() = default;
 				melspec(params& params) {}
 			};
+
+			// melspec of K frames at a time, for offline feature extraction: input is K consecutive melspec inputs,
+			// output K consecutive mel spectra.  The projection is done for the whole block as matrix products (see mel_filterbank::apply_block)
+			template<class traits, size_t K> class melspec_block :
+				public  Processor1A1B<K * traits::input_frame_size, K * traits::n_mels>, virtual public creatable<melspec_block<traits, K>>
+			{
+				melspec_impl<double, traits::input_fs, traits::n_mels, traits::input_frame_size, traits::htk> impl_;
+			public:
+
+				const std::string type() const final {
+					char buf[100];
+					snprintf(buf, 100, "melspec_block[%zd,%zd]", traits::n_mels, K);
+					return buf;
+				}
+
+				void process() final {
+					impl_.fft_mag2mel_block(this->in, traits::input_frame_size, this->out, K);
+				}
+				auto& filterBank() const
+				{
+					return impl_.filterBank();
+				}
+				melspec_block() = default;
+				melspec_block(params& params) {}
+			};
+
+			////// mel_kernels
+			// The mel projection used by melspec_n: a compile-time specialized melspec_impl when the settings match one of
+			// the precompiled configurations, otherwise a filter bank sized at run time.  Both share the filter bank cache.
+			struct mel_kernel
+			{
+				virtual ~mel_kernel() = default;
+				virtual void apply(const samp_t *spectrum, samp_t *mel) const = 0;
+				virtual const mel_filterbank<samp_t>& filterbank() const = 0;
+				virtual bool precompiled() const = 0;
+			};
+
+			namespace mel_kernels {
+
+				template<unsigned SR, unsigned NMELS, unsigned NFFT, bool HTK>struct fixed : mel_kernel
+				{
+					melspec_impl<samp_t, SR, NMELS, NFFT, HTK, samp_t> impl;
+
+					// melspec_impl has fmin = 0, fmax = nyquist, Slaney normalization
+					static bool matches(double sr, size_t n_fft, size_t n_mels, double fmin, double fmax, bool htk, mel_norm norm)
+					{
+						return sr == SR && n_fft == NFFT && n_mels == NMELS && fmin == 0 && fmax == SR / 2.0 && htk == HTK && norm == mel_norm::slaney;
+					}
+
+					void apply(const samp_t *spectrum, samp_t *mel) const final { impl.fft_mag2mel(spectrum, mel); }
+					const mel_filterbank<samp_t>& filterbank() const final { return impl.filterbank(); }
+					bool precompiled() const final { return true; }
+				};
+
+				struct generic : mel_kernel
+				{
+					std::shared_ptr<const mel_filterbank<samp_t>> bank;
+
+					generic(double sr, size_t n_fft, size_t n_mels, double fmin, double fmax, bool htk, mel_norm norm) :
+						bank(mel_filterbank_cache<samp_t>::get().filterbank(sr, n_fft, n_mels, fmin, fmax, htk, norm)) {}
+
+					void apply(const samp_t *spectrum, samp_t *mel) const final { bank->apply(spectrum, mel); }
+					const mel_filterbank<samp_t>& filterbank() const final { return *bank; }
+					bool precompiled() const final { return false; }
+				};
+
+				template<class... KERNELS>struct kernel_list {};
+
+				// the configurations used by the melspec and mfcc unit tests.  Each one adds a melspec_impl instantiation to
+				// every binary, so add others only where they are measured to matter
+				using precompiled = kernel_list<
+					fixed<16000, 80, 1024, false>,
+					fixed<16000, 40, 512, false>
+				>;
+
+				template<class... KERNELS>std::unique_ptr<const mel_kernel> make(kernel_list<KERNELS...>, double sr, size_t n_fft, size_t n_mels, double fmin, double fmax, bool htk, mel_norm norm)
+				{
+					std::unique_ptr<const mel_kernel> kernel;
+					((!kernel && KERNELS::matches(sr, n_fft, n_mels, fmin, fmax, htk, norm) ? (void)(kernel = std::make_unique<KERNELS>()) : (void)0), ...);
+					if (!kernel)
+						kernel = std::make_unique<generic>(sr, n_fft, n_mels, fmin, fmax, htk, norm);
+					return kernel;
+				}
+
+				inline std::unique_ptr<const mel_kernel> make(double sr, size_t n_fft, size_t n_mels, double fmin, double fmax, bool htk, mel_norm norm)
+				{
+					return make(precompiled(), sr, n_fft, n_mels, fmin, fmax, htk, norm);
+				}
+			} // mel_kernels
+
+			// melspec with its settings from params (or XML attributes) instead of traits:
+			// "sr" (default 16000), "n_fft" (required), "n_mels" (default 80), "fmin" (default 0),
+			// "fmax" (default sr/2), "htk" (default false), "norm" ("slaney" (default) or "none").
+			// Input is a magnitude (or power) spectrum of at least n_fft/2+1 bins, e.g. the output of mag, or of mag of fftr_t.
+			struct melspec_n : public Processor<1, 1>, virtual public creatable<melspec_n>
+			{
+				double sr_ = 16000;
+				size_t n_fft_ = 0;
+				size_t n_mels_ = 80;
+				double fmin_ = 0;
+				double fmax_ = 0;
+				bool htk_ = false;
+				mel_norm norm_ = mel_norm::slaney;
+
+				std::unique_ptr<const mel_kernel> kernel_;
+				const double *in = nullptr;
+				double *out = nullptr;
+
+				static mel_norm norm_from_string(const std::string& norm)
+				{
+					if (!_stricmp(norm.c_str(), "slaney"))
+						return mel_norm::slaney;
+					if (!_stricmp(norm.c_str(), "none"))
+						return mel_norm::none;
+					throw eng_ex(format_message("melspec: unknown norm '%s' (use 'slaney' or 'none').", norm.c_str()));
+				}
+
+			public:
+				const std::string type() const final { return "melspec_n"; }
+
+				void freeze() override
+				{
+					port *piport = inports[0];
+					const size_t width = piport->width();
+					// not taken from the input width:  a full spectrum is n_fft wide, but fftr_t's is n_fft/2+1
+					if (!n_fft_)
+						throw eng_ex("melspec_n: n_fft is required.");
+					if (width < n_fft_ / 2 + 1)
+						throw sp_ex_pin_arity();
+					if (!fmax_)
+						fmax_ = sr_ / 2;
+					piport->freezewidth(width);
+					outports[0]->freezewidth(n_mels_);
+					Connectable::freeze();
+
+					in = piport->as_array();
+					out = outports[0]->as_array();
+					kernel_ = mel_kernels::make(sr_, n_fft_, n_mels_, fmin_, fmax_, htk_, norm_);
+				}
+
+				void process() final
+				{
+					kernel_->apply(in, out);
+				}
+
+				const mel_filterbank<samp_t>& filterbank() const { return kernel_->filterbank(); }
+
+				// default constructor needed for factory creation
+				melspec_n() = default;
+
+				melspec_n(double sr, size_t n_fft, size_t n_mels, double fmin = 0, double fmax = 0, bool htk = false, mel_norm norm = mel_norm::slaney) :
+					sr_(sr), n_fft_(n_fft), n_mels_(n_mels), fmin_(fmin), fmax_(fmax), htk_(htk), norm_(norm) {}
+
+				melspec_n(params& args) :
+					sr_(args.get<double>("sr", 16000)),
+					n_fft_(args.get<size_t>("n_fft", 0)),
+					n_mels_(args.get<size_t>("n_mels", 80)),
+					fmin_(args.get<double>("fmin", 0)),
+					fmax_(args.get<double>("fmax", 0)),
+					htk_(args.get<bool>("htk", false)),
+					norm_(norm_from_string(args.get<std::string>("norm", "slaney")))
+				{
+				}
+			};
 		} // proc
 	} // eng
 } // sel
@@ -79,6 +79,63 @@ void run() {
 	for (size_t i = 0; i < filters.size(); ++i)
 		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(filters[i], filters_data[i])
 	
+	// every melspec with the same settings shares one filter bank
+	SEL_UNIT_TEST_ITEM("shared filter bank");
+	{
+		melspec melspec2;
+		SEL_UNIT_TEST_ASSERT(&melspec2.filterBank() == &filters);
+		auto bank = mel_filterbank_cache<double>::get().filterbank(16000, 1024, 80, 0, 8000, ut_traits::htk, mel_norm::slaney);
+		SEL_UNIT_TEST_ASSERT(&bank->weights() == &filters);
+	}
+
+	// run-time configured melspec: settings matching a precompiled configuration use the compile-time kernel
+	SEL_UNIT_TEST_ITEM("melspec_n, precompiled");
+	sel::params melspec_n_params = { "sr", "16000", "n_fft", "1024", "n_mels", "80", "htk", "false", "norm", "slaney" };
+	sel::eng6::proc::melspec_n melspec_n1(melspec_n_params);
+
+	// other settings build their filter bank at run time
+	SEL_UNIT_TEST_ITEM("melspec_n, fmin, fmax, no norm");
+	sel::params melspec_n2_params = { "sr", "16000", "n_fft", "1024", "n_mels", "40", "fmin", "300", "fmax", "7000", "htk", "true", "norm", "none" };
+	sel::eng6::proc::melspec_n melspec_n2(melspec_n2_params);
+
+	// n_fft can't be taken from the input width, which is n_fft/2+1 for fftr_t's spectrum
+	SEL_UNIT_TEST_ITEM("melspec_n, n_fft required");
+	{
+		sel::eng6::proc::rand<ut_traits::input_frame_size / 2 + 1> spectrum;
+		sel::params no_n_fft_params = { "n_mels", "40" };
+		sel::eng6::proc::melspec_n no_n_fft(no_n_fft_params);
+		spectrum.ConnectTo(no_n_fft);
+		bool threw_exception = false;
+		try {
+			no_n_fft.freeze();
+		}
+		catch (sel::eng_ex&) {
+			threw_exception = true;
+		}
+		SEL_UNIT_TEST_ASSERT(threw_exception);
+	}
+
+	// a block of frames through the matrix-product path should match frame-by-frame
+	SEL_UNIT_TEST_ITEM("melspec_block");
+	{
+		constexpr size_t K = 7;
+		sel::eng6::proc::rand<K * ut_traits::input_frame_size> rng_block(1234);
+		sel::eng6::proc::melspec_block<ut_traits, K> melspec_block1;
+		rng_block.ConnectTo(melspec_block1);
+		rng_block.freeze();
+		melspec_block1.freeze();
+		rng_block.process();
+		melspec_block1.process();
+		SEL_UNIT_TEST_ASSERT(&melspec_block1.filterBank() == &filters);
+		auto bank = mel_filterbank_cache<double>::get().filterbank(16000, 1024, 80, 0, 8000, ut_traits::htk, mel_norm::slaney);
+		std::array<double, ut_traits::n_mels> frame_mel;
+		for (size_t k = 0; k < K; ++k) {
+			bank->apply(rng_block.out + k * ut_traits::input_frame_size, frame_mel.data());
+			for (size_t i = 0; i < ut_traits::n_mels; ++i)
+				SEL_UNIT_TEST_EQUAL_THRESH(frame_mel[i], melspec_block1.out[k * ut_traits::n_mels + i], 1e-12 * (1 + std::abs(frame_mel[i])));
+		}
+	}
+
 	const auto seed = 5489U;
 	sel::eng6::proc::rand<ut_traits::input_frame_size> rng1(seed);
 	
@@ -96,11 +153,44 @@ void run() {
     graph.connect(fft1, mag1);
     graph.connect(mag1, square1);
 	graph.connect(square1, melspec1);
+	graph.connect(square1, melspec_n1);
+	graph.connect(square1, melspec_n2);
 
 	rng1.raise();  // run one schedule
 	s.init();
 	s.step();
 
+	// only the nonzero span of each filter is used: should match the dense product with the filter bank
+	SEL_UNIT_TEST_ITEM("sparse filter bank");
+	constexpr size_t n_bins = ut_traits::input_frame_size / 2 + 1;
+	for (size_t i = 0; i < ut_traits::n_mels; ++i) {
+		double dense = 0;
+		for (size_t j = 0; j < n_bins; ++j)
+			dense += filters[i * n_bins + j] * square1.out[j];
+		SEL_UNIT_TEST_EQUAL_THRESH(dense, melspec1.out[i], 1e-12 * (1 + std::abs(dense)));
+	}
+
+	SEL_UNIT_TEST_ITEM("melspec_n process(), precompiled");
+	SEL_UNIT_TEST_ASSERT(melspec_n1.filterbank().n_mels == ut_traits::n_mels);
+	SEL_UNIT_TEST_ASSERT(&melspec_n1.filterbank().weights() == &melspec1.filterBank());
+	for (size_t i = 0; i < ut_traits::n_mels; ++i)
+		SEL_UNIT_TEST_ASSERT(melspec_n1.out[i] == melspec1.out[i]);
+
+	SEL_UNIT_TEST_ITEM("melspec_n process(), fmin, fmax, no norm");
+	py::array_t<double> filters2_py = librosa.attr("filters").attr("mel")(16000, 1024, "n_mels"_a = 40, "fmin"_a = 300, "fmax"_a = 7000, "htk"_a = true, "norm"_a = py::none());
+	auto filters2_data = filters2_py.data();
+	auto& filters2 = melspec_n2.filterbank().weights();
+	SEL_UNIT_TEST_ASSERT(melspec_n2.filterbank().n_mels == 40);
+	SEL_UNIT_TEST_ASSERT(filters2_py.size() == filters2.size())
+	for (size_t i = 0; i < filters2.size(); ++i)
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(filters2[i], filters2_data[i])
+	for (size_t i = 0; i < 40; ++i) {
+		double dense = 0;
+		for (size_t j = 0; j < n_bins; ++j)
+			dense += filters2_data[i * n_bins + j] * square1.out[j];
+		SEL_UNIT_TEST_EQUAL_THRESH(dense, melspec_n2.out[i], 1e-5 * (1 + std::abs(dense)));
+	}
+
 	// compare with librosa
 	SEL_UNIT_TEST_ITEM("melspec process()");
 
@@ -0,0 +1,94 @@
+#pragma once
+// Fused mel-frequency cepstral coefficients
+#include <algorithm>
+#include <cmath>
+#include "../melspec_impl.h"
+#include "../processor.h"
+#include "../factory.h"
+#include "dct.h"
+
+namespace sel {
+	namespace eng6 {
+		namespace proc {
+
+			// MFCCs of a real fft (the output of fftr_t), in one processor.  Produces the same output as the chain
+			//		fftr_t -> mag -> melspec -> log (expr) -> fast_dct<..., 2, Ortho>, keeping the first NMfcc coefficients
+			// (with Power = 2, a square after mag, i.e. the power spectrum, as librosa), without writing the intermediates to ports.
+			// The power spectrum is computed directly from the complex bins, the mel projection uses only the nonzero span of each
+			// filter (as melspec), and the log is a separate tight loop, which the compiler can vectorize with a vector math library.
+			// Mel values below floor (default 1e-10, from params "floor") are clamped before the log.
+			// traits as melspec:  input_frame_size (the fft size), input_fs, n_mels, htk
+			template<class traits, size_t NMfcc = 13, size_t Power = 2, bool Ortho = true> class mfcc :
+				public Processor1A1B<2 * (traits::input_frame_size / 2 + 1), NMfcc>, virtual public creatable<mfcc<traits, NMfcc, Power, Ortho>>
+			{
+				static_assert(Power == 1 || Power == 2, "mfcc: Power must be 1 (magnitude) or 2 (power)");
+				static_assert(NMfcc <= traits::n_mels, "mfcc: more coefficients than mel bands");
+
+				static constexpr size_t N_BINS = traits::input_frame_size / 2 + 1;
+				static constexpr size_t N_MELS = traits::n_mels;
+
+				melspec_impl<samp_t, traits::input_fs, N_MELS, traits::input_frame_size, traits::htk> melspec_;
+				fast_dct_impl<N_MELS, 2, Ortho> dct_;
+				samp_t floor_ = 1e-10;
+
+				// intermediates, a few KB
+				std::vector<samp_t> spectrum_ = std::vector<samp_t>(N_BINS);
+				std::vector<samp_t> mel_ = std::vector<samp_t>(N_MELS);
+				std::vector<samp_t> cepstrum_ = std::vector<samp_t>(N_MELS);
+
+			public:
+				const std::string type() const final {
+					char buf[100];
+					snprintf(buf, 100, "mfcc[%zd]", NMfcc);
+					return buf;
+				}
+
+				void process() final
+				{
+					const samp_t *in = this->in;
+					samp_t *spectrum = spectrum_.data();
+					samp_t *mel = mel_.data();
+					samp_t *cepstrum = cepstrum_.data();
+
+					if constexpr (Power == 2) {
+						for (size_t i = 0; i < N_BINS; ++i)
+							spectrum[i] = in[2 * i] * in[2 * i] + in[2 * i + 1] * in[2 * i + 1];
+					}
+					else {
+						const auto in_as_complex_array = reinterpret_cast<const csamp_t*>(in);
+						for (size_t i = 0; i < N_BINS; ++i)
+							spectrum[i] = abs(in_as_complex_array[i]);
+					}
+
+					melspec_.fft_mag2mel(spectrum, mel);
+
+					const samp_t floor = floor_;
+					for (size_t i = 0; i < N_MELS; ++i)
+						mel[i] = std::log(std::max(mel[i], floor));
+
+					if constexpr (NMfcc == N_MELS)
+						dct_.transform(mel, this->out);
+					else {
+						dct_.transform(mel, cepstrum);
+						std::copy(cepstrum, cepstrum + NMfcc, this->out);
+					}
+				}
+
+				auto& filterBank() const
+				{
+					return melspec_.filterBank();
+				}
+
+				// default constructor needed for factory creation
+				mfcc() = default;
+
+				mfcc(params& args) : floor_(args.get<double>("floor", 1e-10))
+				{
+				}
+			};
+		} // proc
+	} // eng
+} // sel
+#if defined(COMPILE_UNIT_TESTS)
+#include "mfcc_ut.h"
+#endif
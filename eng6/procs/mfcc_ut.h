@@ -0,0 +1,136 @@
+#pragma once
+// fused mfcc unit test:  against the chain of separate processors
+#include "mfcc.h"
+#include "rand.h"
+#include "window.h"
+#include "fft.h"
+#include "mag.h"
+#include "melspec.h"
+#include "expr.h"
+#include "dct.h"
+#include "../unit_test.h"
+
+SEL_UNIT_TEST(mfcc)
+
+struct ut_traits
+{
+	static constexpr size_t n_mels = 40;
+	static constexpr size_t input_frame_size = 512;
+	static constexpr size_t input_fs = 16000;
+	static constexpr size_t overlap = 0;
+	static constexpr bool htk = false;
+};
+
+static constexpr size_t N_BINS = ut_traits::input_frame_size / 2 + 1;
+static constexpr size_t N_MFCC = 13;
+
+struct square : public sel::eng6::Processor1A1B<N_BINS, N_BINS>
+{
+	void process() final
+	{
+		for (size_t i = 0; i < N_BINS; ++i)
+			this->out[i] = this->in[i] * this->in[i];
+	}
+};
+
+// fftr -> mag -> [square] -> melspec -> log -> dct
+struct chain
+{
+	sel::eng6::proc::mag<ut_traits, N_BINS> mag1;
+	square square1;
+	sel::params melspec_params = { "n_fft", "512", "n_mels", "40" };
+	sel::eng6::proc::melspec_n melspec1 = sel::eng6::proc::melspec_n(melspec_params);
+	sel::params log_params = { "expr", "output := log(input1)" };
+	sel::eng6::proc::expr log1 = sel::eng6::proc::expr(log_params);
+	sel::eng6::proc::fast_dct<ut_traits, 2, true, ut_traits::n_mels> dct1;
+	const bool power;
+
+	chain(sel::Connectable<samp_t>& spectrum, bool power) : power(power)
+	{
+		spectrum.ConnectTo(mag1);
+		if (power) {
+			mag1.ConnectTo(square1);
+			square1.ConnectTo(melspec1);
+		} else
+			mag1.ConnectTo(melspec1);
+		melspec1.ConnectTo(log1);
+		log1.ConnectTo(dct1);
+		mag1.freeze();
+		if (power)
+			square1.freeze();
+		melspec1.freeze();
+		log1.freeze();
+		dct1.freeze();
+	}
+
+	void process()
+	{
+		mag1.process();
+		if (power)
+			square1.process();
+		melspec1.process();
+		log1.process();
+		dct1.process();
+	}
+};
+
+void run() {
+	sel::eng6::proc::rand<ut_traits::input_frame_size> rng1;
+	sel::eng6::proc::window_t<ut_traits, sel::eng6::proc::wintype::HANN<ut_traits>, ut_traits::input_frame_size> window1;
+	sel::eng6::proc::fftr_t<ut_traits> fftr1;
+	sel::params mfcc_params = { "floor", "0" };
+	sel::eng6::proc::mfcc<ut_traits, N_MFCC> mfcc_power(mfcc_params);
+	sel::eng6::proc::mfcc<ut_traits, N_MFCC, 1> mfcc_mag(mfcc_params);
+
+	rng1.ConnectTo(window1);
+	window1.ConnectTo(fftr1);
+	fftr1.ConnectTo(mfcc_power);
+	fftr1.ConnectTo(mfcc_mag);
+	rng1.freeze();
+	window1.freeze();
+	fftr1.freeze();
+	mfcc_power.freeze();
+	mfcc_mag.freeze();
+
+	chain chain_power(fftr1, true);
+	chain chain_mag(fftr1, false);
+
+	double max_diff = 0;
+	bool mag_identical = true;
+	for (size_t frame = 0; frame < 10; ++frame) {
+		rng1.process();
+		window1.process();
+		fftr1.process();
+		mfcc_power.process();
+		mfcc_mag.process();
+		chain_power.process();
+		chain_mag.process();
+
+		for (size_t i = 0; i < N_MFCC; ++i) {
+			max_diff = std::max(max_diff, std::abs(mfcc_power.out[i] - chain_power.dct1.out[i]) / (1 + std::abs(chain_power.dct1.out[i])));
+			mag_identical = mag_identical && mfcc_mag.out[i] == chain_mag.dct1.out[i];
+		}
+	}
+
+	// the same operations in the same order as the chain
+	SEL_UNIT_TEST_ITEM("magnitude, against chain");
+	SEL_UNIT_TEST_ASSERT(mag_identical);
+
+	// re^2 + im^2 rather than |z| squared:  equal to rounding
+	SEL_UNIT_TEST_ITEM("power, against chain");
+	SEL_UNIT_TEST_EQUAL_THRESH(max_diff, 0.0, 1e-12);
+
+	SEL_UNIT_TEST_ITEM("floor");
+	const samp_t silence[2 * N_BINS] = {};
+	sel::eng6::Const zeros(silence, silence + 2 * N_BINS);
+	sel::eng6::proc::mfcc<ut_traits, N_MFCC> mfcc_silence;
+	zeros.ConnectTo(mfcc_silence);
+	mfcc_silence.freeze();
+	mfcc_silence.process();
+	// log(1e-10) in every band:  only c0 is nonzero
+	SEL_UNIT_TEST_EQUAL_THRESH(mfcc_silence.out[0], std::log(1e-10) * std::sqrt(double(ut_traits::n_mels)), 1e-9);
+	for (size_t i = 1; i < N_MFCC; ++i)
+		SEL_UNIT_TEST_EQUAL_THRESH(mfcc_silence.out[i], 0.0, 1e-9);
+}
+
+SEL_UNIT_TEST_END
@@ -56,6 +56,7 @@ namespace sel {
 						if (context->trigger() != owner)
 							throw eng_ex("Mux/Demux output must be triggered by the mux_demux itself.");
 						this->context = context;
+						context->set_invoked();
 					}
 
 					void process() final
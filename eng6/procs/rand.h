@@ -27,6 +27,15 @@ namespace sel
 						rng(); // discard next number, to match up with Matlab's rng
 					}
 				}
+
+				bool block_capable() const final { return true; }
+				void process_block(size_t n) final
+				{
+					for (size_t i = 0; i < n * OutW; ++i) {
+						this->out[i] = urd(rng);
+						rng();
+					}
+				}
 				// std::mt19937::default_seed == 5489U which matches Matlab
 				explicit rand(unsigned int seed = std::mt19937::default_seed) : urd(0,1)
 				{
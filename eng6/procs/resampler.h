@@ -75,6 +75,7 @@ namespace sel {
 					if (context->trigger() != this)
 						throw eng_ex("Resampler output must be triggered by the resampler itself.");
 					this->output_context = context;
+					context->set_invoked();
 				}
 
 				void process() final
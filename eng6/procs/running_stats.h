@@ -73,7 +73,21 @@ namespace sel {
 
 				void process() final 
 				{
-					const auto v = *this->inports[0]->as_array();
+					process_frame_(0);
+				}
+
+				bool block_capable() const final { return true; }
+				void process_block(size_t n) final
+				{
+					for (size_t k = 0; k < n; ++k)
+						process_frame_(k);
+				}
+
+			private:
+				// frame k of the input and output ports
+				void process_frame_(size_t k)
+				{
+					const auto v = this->inports[0]->as_array()[k];
 					
 					const auto oldest_v = buf_[idx_];
 
@@ -142,19 +156,19 @@ namespace sel {
 					}
 
 					// update outputs
-					*outports[port_id_mean()]->as_array() = mean;
-					*outports[port_id_max_in_range()]->as_array() = max;
-					*outports[port_id_min_in_range()]->as_array() = min;
+					outports[port_id_mean()]->as_array()[k] = mean;
+					outports[port_id_max_in_range()]->as_array()[k] = max;
+					outports[port_id_min_in_range()]->as_array()[k] = min;
 					if (calc_var_) {
-						*outports[port_id_var()]->as_array() = var;
-						*outports[port_id_stddev()]->as_array() = sqrt(var);
+						outports[port_id_var()]->as_array()[k] = var;
+						outports[port_id_stddev()]->as_array()[k] = sqrt(var);
 					}
 					if (calc_gradient_) {
-						*outports[port_id_gradient()]->as_array() = b1 / b2();
+						outports[port_id_gradient()]->as_array()[k] = b1 / b2();
 					}
-					*outports[port_id_zero_crossing()]->as_array() = static_cast<samp_t>(zc) / Sz; // zero crossing as percentage of buffer size
-					*outports[port_id_energy()]->as_array() = sum_sqrs_;
-					*outports[port_id_power()]->as_array() = sum_sqrs_ / Sz;
+					outports[port_id_zero_crossing()]->as_array()[k] = static_cast<samp_t>(zc) / Sz; // zero crossing as percentage of buffer size
+					outports[port_id_energy()]->as_array()[k] = sum_sqrs_;
+					outports[port_id_power()]->as_array()[k] = sum_sqrs_ / Sz;
 					
 				}
 			};
@@ -0,0 +1,144 @@
+#pragma once
+/*
+Sliding DFT
+
+The spectrum of the last N samples, updated recursively as each sample arrives (hop = 1), at O(bins) per sample
+instead of O(N log N) per frame:
+	X[k] <- (X[k] + x[n] - x[n-N]) * e^(2*pi*i*k/N)
+
+Rounding errors in the recursion accumulate, so every "reanchor" samples the bins are recomputed exactly
+from the sample history with an N-point fft.
+*/
+#include "../processor.h"
+#include "fft_plan.h"
+#include "simd.h"
+
+namespace sel {
+	namespace eng6 {
+		namespace proc {
+
+			// Input: the new samples (any number per process(), usually 1).
+			// Output: bins first_bin .. first_bin+bins-1 (complex, interleaved) of the N-point dft of the last N samples,
+			// oldest first (so bins match fft_n of the same N samples).
+			// Params: "size" (N, required), "first_bin" (default 0), "bins" (default N/2+1 - first_bin), "reanchor" (default N)
+			struct sdft : public Processor<1, 1>, virtual public creatable<sdft>
+			{
+				size_t size_ = 0;
+				size_t first_bin_ = 0;
+				size_t bins_ = 0;
+				size_t reanchor_ = 0;
+
+				// bins and per-bin rotations, in structure-of-arrays layout for the vectorized update
+				std::vector<samp_t> re_, im_, cr_, ci_;
+				// the last N samples, circular.  pos_ is the oldest
+				std::vector<samp_t> history_;
+				size_t pos_ = 0;
+				size_t since_anchor_ = 0;
+
+				std::shared_ptr<const fft_plan<samp_t>> plan_;
+				std::vector<samp_t> scratch_;
+
+				size_t hop_ = 0;
+				const double *in = nullptr;
+				double *out = nullptr;
+
+				// recompute the bins from the history
+				void anchor()
+				{
+					samp_t *x = scratch_.data();
+					for (size_t i = 0; i < size_; ++i) {
+						x[2 * i] = history_[(pos_ + i) % size_];
+						x[2 * i + 1] = 0;
+					}
+					plan_->execute(x);
+					for (size_t j = 0; j < bins_; ++j) {
+						re_[j] = x[2 * (first_bin_ + j)];
+						im_[j] = x[2 * (first_bin_ + j) + 1];
+					}
+					since_anchor_ = 0;
+				}
+
+			public:
+				const std::string type() const final { return "sdft"; }
+
+				void freeze() override
+				{
+					if (size_ < 2)
+						throw eng_ex(format_message("sdft: size must be at least 2 (got %zd).", size_));
+					if (!bins_ && first_bin_ <= size_ / 2)
+						bins_ = size_ / 2 + 1 - first_bin_;
+					if (!bins_ || first_bin_ + bins_ > size_)
+						throw eng_ex(format_message("sdft: bins [%zd, %zd) out of range for size %zd.", first_bin_, first_bin_ + bins_, size_));
+					if (!reanchor_)
+						reanchor_ = size_;
+
+					port *piport = inports[0];
+					hop_ = piport->width();
+					if (!hop_)
+						throw sp_ex_pin_arity();
+					piport->freezewidth(hop_);
+					outports[0]->freezewidth(2 * bins_);
+					Connectable::freeze();
+
+					in = piport->as_array();
+					out = outports[0]->as_array();
+
+					re_.assign(bins_, 0);
+					im_.assign(bins_, 0);
+					cr_.resize(bins_);
+					ci_.resize(bins_);
+					for (size_t j = 0; j < bins_; ++j) {
+						long double s = 0, c = 0;
+						fft_tables::sincos_2pi(first_bin_ + j, size_, s, c);
+						cr_[j] = static_cast<samp_t>(c);
+						ci_[j] = static_cast<samp_t>(s);
+					}
+					history_.assign(size_, 0);
+					pos_ = 0;
+					since_anchor_ = 0;
+					scratch_.resize(2 * size_);
+					plan_ = fft_plan_cache::get().plan<samp_t>(size_, fft_direction::forward);
+				}
+
+				void process() final
+				{
+					for (size_t h = 0; h < hop_; ++h) {
+						const samp_t x = in[h];
+						const samp_t delta = x - history_[pos_];
+						history_[pos_] = x;
+						if (++pos_ == size_)
+							pos_ = 0;
+
+						if (++since_anchor_ == reanchor_)
+							anchor();
+						else
+							simd::sdft_update(re_.data(), im_.data(), cr_.data(), ci_.data(), static_cast<unsigned>(bins_), delta);
+					}
+
+					for (size_t j = 0; j < bins_; ++j) {
+						out[2 * j] = re_[j];
+						out[2 * j + 1] = im_[j];
+					}
+				}
+
+				// default constuctor needed for factory creation
+				explicit sdft() {}
+
+				explicit sdft(size_t size, size_t first_bin = 0, size_t bins = 0, size_t reanchor = 0) :
+					size_(size), first_bin_(first_bin), bins_(bins), reanchor_(reanchor) {}
+
+				sdft(params& args) :
+					size_(args.get<size_t>("size", 0)),
+					first_bin_(args.get<size_t>("first_bin", 0)),
+					bins_(args.get<size_t>("bins", 0)),
+					reanchor_(args.get<size_t>("reanchor", 0))
+				{
+				}
+			};
+		} // proc
+	} // eng
+} // sel
+
+#if defined(COMPILE_UNIT_TESTS)
+#include "sdft_ut.h"
+#endif
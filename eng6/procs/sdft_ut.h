@@ -0,0 +1,92 @@
+#pragma once
+// sliding dft unit test
+#include "sdft.h"
+#include "rand.h"
+#include <deque>
+#include "../unit_test.h"
+
+SEL_UNIT_TEST(sdft)
+
+static constexpr size_t N = 64;
+
+// fft of the last N samples, oldest first
+std::vector<samp_t> reference(const std::deque<samp_t>& last)
+{
+	std::vector<samp_t> x(2 * N, 0.0);
+	for (size_t i = 0; i < N; ++i)
+		x[2 * i] = last[i];
+	sel::eng6::proc::fft_plan_cache::get().plan<samp_t>(N, sel::eng6::proc::fft_direction::forward)->execute(x.data());
+	return x;
+}
+
+void run() {
+	// one sample per process(), all N/2+1 bins, re-anchored every 1000 samples
+	sel::eng6::proc::rand<1> rng1;
+	sel::eng6::proc::sdft sdft1(N, 0, 0, 1000);
+	// four samples per process(), bins 5..14, re-anchored every 10 samples
+	sel::eng6::proc::rand<4> rng4(1234);
+	sel::params sdft4_params = { "size", "64", "first_bin", "5", "bins", "10", "reanchor", "10" };
+	sel::eng6::proc::sdft sdft4(sdft4_params);
+
+	rng1.ConnectTo(sdft1);
+	rng4.ConnectTo(sdft4);
+	rng1.freeze();
+	sdft1.freeze();
+	rng4.freeze();
+	sdft4.freeze();
+
+	std::deque<samp_t> last1(N, 0.0), last4(N, 0.0);
+	for (size_t i = 0; i < 3 * N + 7; ++i) {
+		rng1.process();
+		sdft1.process();
+		last1.pop_front();
+		last1.push_back(rng1.out[0]);
+
+		rng4.process();
+		sdft4.process();
+		for (size_t h = 0; h < 4; ++h) {
+			last4.pop_front();
+			last4.push_back(rng4.out[h]);
+		}
+	}
+
+	SEL_UNIT_TEST_ITEM("hop 1, all bins");
+	auto ref1 = reference(last1);
+	for (size_t k = 0; k < 2 * (N / 2 + 1); ++k)
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(sdft1.out[k], ref1[k]);
+
+	SEL_UNIT_TEST_ITEM("hop 4, bin subset, re-anchored");
+	auto ref4 = reference(last4);
+	for (size_t k = 0; k < 2 * 10; ++k)
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(sdft4.out[k], ref4[2 * 5 + k]);
+
+	// after a long run, the default re-anchoring (every N samples) keeps the bins as close to the exact spectrum as after a
+	// short one.  Without re-anchoring, the rounding errors in the recursion accumulate (to about 5e-13 here)
+	SEL_UNIT_TEST_ITEM("drift");
+	sel::eng6::proc::rand<1> rng_default(99), rng_never(99);
+	sel::eng6::proc::sdft sdft_default(N);
+	sel::eng6::proc::sdft sdft_never(N, 0, 0, std::numeric_limits<size_t>::max());
+	rng_default.ConnectTo(sdft_default);
+	rng_never.ConnectTo(sdft_never);
+	rng_default.freeze();
+	sdft_default.freeze();
+	rng_never.freeze();
+	sdft_never.freeze();
+
+	std::deque<samp_t> last(N, 0.0);
+	for (size_t i = 0; i < 100000 + 7; ++i) {
+		rng_default.process();
+		sdft_default.process();
+		rng_never.process();
+		sdft_never.process();
+		last.pop_front();
+		last.push_back(rng_default.out[0]);
+	}
+	auto ref = reference(last);
+	for (size_t k = 0; k < 2 * (N / 2 + 1); ++k) {
+		SEL_UNIT_TEST_EQUAL_THRESH(sdft_default.out[k], ref[k], 1e-12);
+		SEL_UNIT_TEST_EQUAL_THRESH(sdft_never.out[k], ref[k], 1e-9);
+	}
+}
+
+SEL_UNIT_TEST_END
@@ -0,0 +1,287 @@
+#pragma once
+/*
+    Vectorized kernels, with the instruction set chosen at runtime
+
+    The kernels in simd_kernels.h (and the fft butterflies in fft_simd_kernels.h) are compiled once for each
+    instruction set below, on the vector types V<T> defined here.  The instruction set is chosen at runtime,
+    from the CPU's features, so the binary does not need to be built with -mavx2 or -mavx512f.
+    Non-x86 builds use the scalar kernels only.
+
+    simd::force_isa() can be used to override the detected instruction set (e.g. for testing
+    the scalar fallback), but can never select an instruction set the CPU does not support.
+*/
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SEL_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// Compile the enclosed functions for a specific instruction set.  MSVC doesn't need this.
+#if defined(__clang__)
+#define SEL_SIMD_TARGET_AVX2_BEGIN _Pragma("clang attribute push(__attribute__((target(\"avx2,fma\"))), apply_to = function)")
+#define SEL_SIMD_TARGET_AVX512_BEGIN _Pragma("clang attribute push(__attribute__((target(\"avx512f,avx2,fma\"))), apply_to = function)")
+#define SEL_SIMD_TARGET_END _Pragma("clang attribute pop")
+#elif defined(__GNUC__)
+#define SEL_SIMD_TARGET_AVX2_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx2,fma\")")
+#define SEL_SIMD_TARGET_AVX512_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f,avx2,fma\")")
+#define SEL_SIMD_TARGET_END _Pragma("GCC pop_options")
+#else
+#define SEL_SIMD_TARGET_AVX2_BEGIN
+#define SEL_SIMD_TARGET_AVX512_BEGIN
+#define SEL_SIMD_TARGET_END
+#endif
+
+// GCC's avx512 intrinsics pass _mm512_undefined_pd() as the (masked off) source operand, which -Wmaybe-uninitialized
+// (or -Wuninitialized) reports wherever they are inlined
+#if defined(__GNUC__) && !defined(__clang__)
+#define SEL_SIMD_AVX512_WARNINGS_BEGIN _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"") \
+    _Pragma("GCC diagnostic ignored \"-Wuninitialized\"")
+#define SEL_SIMD_AVX512_WARNINGS_END _Pragma("GCC diagnostic pop")
+#else
+#define SEL_SIMD_AVX512_WARNINGS_BEGIN
+#define SEL_SIMD_AVX512_WARNINGS_END
+#endif
+
+namespace simd {
+
+    enum class isa { scalar = 0, avx2 = 1, avx512 = 2 };
+
+    inline const char *isa_name(isa i) {
+        switch (i) {
+            case isa::avx512: return "avx512";
+            case isa::avx2: return "avx2";
+            default: return "scalar";
+        }
+    }
+
+    // best instruction set supported by this CPU (and OS)
+    inline isa detect_isa() {
+#if defined(SEL_SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+        int regs[4];
+        __cpuid(regs, 0);
+        if (regs[0] < 7)
+            return isa::scalar;
+        __cpuid(regs, 1);
+        const bool osxsave = (regs[2] & (1 << 27)) != 0;
+        const bool fma = (regs[2] & (1 << 12)) != 0;
+        if (!osxsave)
+            return isa::scalar;
+        const auto xcr0 = _xgetbv(0);
+        __cpuidex(regs, 7, 0);
+        const bool avx2 = fma && (regs[1] & (1 << 5)) != 0 && (xcr0 & 0x06) == 0x06;
+        const bool avx512 = avx2 && (regs[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+#else
+        __builtin_cpu_init();
+        const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        const bool avx512 = avx2 && __builtin_cpu_supports("avx512f");
+#endif
+        if (avx512)
+            return isa::avx512;
+        if (avx2)
+            return isa::avx2;
+#endif
+        return isa::scalar;
+    }
+
+    inline std::atomic<isa>& active_isa_() {
+        static std::atomic<isa> active{ detect_isa() };
+        return active;
+    }
+
+    inline isa active_isa() { return active_isa_().load(std::memory_order_relaxed); }
+
+    // Use (at most) the given instruction set.  Returns the instruction set actually selected.
+    inline isa force_isa(isa requested) {
+        const auto best = detect_isa();
+        const auto selected = static_cast<int>(requested) < static_cast<int>(best) ? requested : best;
+        active_isa_().store(selected);
+        return selected;
+    }
+
+    // V<T> holds V<T>::width complex values, in interleaved (re, im) order, and provides
+    // load(), store(), add(), sub(), cmul() (complex multiply), mul_i() (multiply by i), mul_negi() (multiply by -i)
+    // mul() (multiply by a real scalar) and broadcast() (load one complex value into every lane).
+    // Its type is also used as a vector of 2 * V<T>::width reals, with splat() (broadcast a real) and mulv() (element-wise multiply).
+
+    namespace scalar {
+        template<typename T>struct V {
+            static constexpr unsigned width = 1;
+            struct type { T re, im; };
+
+            static type load(const T *p) { return { p[0], p[1] }; }
+            static void store(T *p, const type& a) { p[0] = a.re; p[1] = a.im; }
+            static type add(const type& a, const type& b) { return { a.re + b.re, a.im + b.im }; }
+            static type sub(const type& a, const type& b) { return { a.re - b.re, a.im - b.im }; }
+            static type cmul(const type& a, const type& w) { return { a.re * w.re - a.im * w.im, a.re * w.im + a.im * w.re }; }
+            static type mul_i(const type& a) { return { -a.im, a.re }; }
+            static type mul_negi(const type& a) { return { a.im, -a.re }; }
+            static type mul(const type& a, T s) { return { a.re * s, a.im * s }; }
+            static type broadcast(const T *p) { return load(p); }
+            static type splat(T s) { return { s, s }; }
+            static type mulv(const type& a, const type& b) { return { a.re * b.re, a.im * b.im }; }
+        };
+#include "simd_kernels.h"
+    }
+
+#if defined(SEL_SIMD_X86)
+SEL_SIMD_TARGET_AVX2_BEGIN
+    namespace avx2 {
+        template<typename T>struct V;
+
+        template<>struct V<double> {
+            static constexpr unsigned width = 2;
+            using type = __m256d;
+
+            static type load(const double *p) { return _mm256_loadu_pd(p); }
+            static void store(double *p, type a) { _mm256_storeu_pd(p, a); }
+            static type add(type a, type b) { return _mm256_add_pd(a, b); }
+            static type sub(type a, type b) { return _mm256_sub_pd(a, b); }
+            // (ar*wr - ai*wi, ai*wr + ar*wi)
+            static type cmul(type a, type w) {
+                const auto wr = _mm256_movedup_pd(w);
+                const auto wi = _mm256_permute_pd(w, 0xf);
+                const auto a_swapped = _mm256_permute_pd(a, 0x5);
+                return _mm256_fmaddsub_pd(a, wr, _mm256_mul_pd(a_swapped, wi));
+            }
+            static type mul_i(type a) { return _mm256_xor_pd(_mm256_permute_pd(a, 0x5), _mm256_setr_pd(-0.0, 0.0, -0.0, 0.0)); }
+            static type mul_negi(type a) { return _mm256_xor_pd(_mm256_permute_pd(a, 0x5), _mm256_setr_pd(0.0, -0.0, 0.0, -0.0)); }
+            static type mul(type a, double s) { return _mm256_mul_pd(a, _mm256_set1_pd(s)); }
+            static type broadcast(const double *p) { return _mm256_blend_pd(_mm256_set1_pd(p[0]), _mm256_set1_pd(p[1]), 0xa); }
+            static type splat(double s) { return _mm256_set1_pd(s); }
+            static type mulv(type a, type b) { return _mm256_mul_pd(a, b); }
+        };
+
+        template<>struct V<float> {
+            static constexpr unsigned width = 4;
+            using type = __m256;
+
+            static type load(const float *p) { return _mm256_loadu_ps(p); }
+            static void store(float *p, type a) { _mm256_storeu_ps(p, a); }
+            static type add(type a, type b) { return _mm256_add_ps(a, b); }
+            static type sub(type a, type b) { return _mm256_sub_ps(a, b); }
+            static type cmul(type a, type w) {
+                const auto wr = _mm256_moveldup_ps(w);
+                const auto wi = _mm256_movehdup_ps(w);
+                const auto a_swapped = _mm256_permute_ps(a, 0xb1);
+                return _mm256_fmaddsub_ps(a, wr, _mm256_mul_ps(a_swapped, wi));
+            }
+            static type mul_i(type a) { return _mm256_xor_ps(_mm256_permute_ps(a, 0xb1), _mm256_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f)); }
+            static type mul_negi(type a) { return _mm256_xor_ps(_mm256_permute_ps(a, 0xb1), _mm256_setr_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f)); }
+            static type mul(type a, float s) { return _mm256_mul_ps(a, _mm256_set1_ps(s)); }
+            static type broadcast(const float *p) { return _mm256_blend_ps(_mm256_set1_ps(p[0]), _mm256_set1_ps(p[1]), 0xaa); }
+            static type splat(float s) { return _mm256_set1_ps(s); }
+            static type mulv(type a, type b) { return _mm256_mul_ps(a, b); }
+        };
+#include "simd_kernels.h"
+    }
+SEL_SIMD_TARGET_END
+
+SEL_SIMD_AVX512_WARNINGS_BEGIN
+SEL_SIMD_TARGET_AVX512_BEGIN
+    namespace avx512 {
+        template<typename T>struct V;
+
+        template<>struct V<double> {
+            static constexpr unsigned width = 4;
+            using type = __m512d;
+
+            static type load(const double *p) { return _mm512_loadu_pd(p); }
+            static void store(double *p, type a) { _mm512_storeu_pd(p, a); }
+            static type add(type a, type b) { return _mm512_add_pd(a, b); }
+            static type sub(type a, type b) { return _mm512_sub_pd(a, b); }
+            static type cmul(type a, type w) {
+                const auto wr = _mm512_shuffle_pd(w, w, 0x00);
+                const auto wi = _mm512_shuffle_pd(w, w, 0xff);
+                const auto a_swapped = _mm512_shuffle_pd(a, a, 0x55);
+                return _mm512_fmaddsub_pd(a, wr, _mm512_mul_pd(a_swapped, wi));
+            }
+            // avx512f has no floating point xor, so negate with a blend
+            static type mul_i(type a) {
+                const auto s = _mm512_shuffle_pd(a, a, 0x55);
+                return _mm512_mask_sub_pd(s, 0x55, _mm512_setzero_pd(), s);
+            }
+            static type mul_negi(type a) {
+                const auto s = _mm512_shuffle_pd(a, a, 0x55);
+                return _mm512_mask_sub_pd(s, 0xaa, _mm512_setzero_pd(), s);
+            }
+            static type mul(type a, double s) { return _mm512_mul_pd(a, _mm512_set1_pd(s)); }
+            static type broadcast(const double *p) { return _mm512_mask_blend_pd(0xaa, _mm512_set1_pd(p[0]), _mm512_set1_pd(p[1])); }
+            static type splat(double s) { return _mm512_set1_pd(s); }
+            static type mulv(type a, type b) { return _mm512_mul_pd(a, b); }
+        };
+
+        template<>struct V<float> {
+            static constexpr unsigned width = 8;
+            using type = __m512;
+
+            static type load(const float *p) { return _mm512_loadu_ps(p); }
+            static void store(float *p, type a) { _mm512_storeu_ps(p, a); }
+            static type add(type a, type b) { return _mm512_add_ps(a, b); }
+            static type sub(type a, type b) { return _mm512_sub_ps(a, b); }
+            static type cmul(type a, type w) {
+                const auto wr = _mm512_moveldup_ps(w);
+                const auto wi = _mm512_movehdup_ps(w);
+                const auto a_swapped = _mm512_permute_ps(a, 0xb1);
+                return _mm512_fmaddsub_ps(a, wr, _mm512_mul_ps(a_swapped, wi));
+            }
+            static type mul_i(type a) {
+                const auto s = _mm512_permute_ps(a, 0xb1);
+                return _mm512_mask_sub_ps(s, 0x5555, _mm512_setzero_ps(), s);
+            }
+            static type mul_negi(type a) {
+                const auto s = _mm512_permute_ps(a, 0xb1);
+                return _mm512_mask_sub_ps(s, 0xaaaa, _mm512_setzero_ps(), s);
+            }
+            static type mul(type a, float s) { return _mm512_mul_ps(a, _mm512_set1_ps(s)); }
+            static type broadcast(const float *p) { return _mm512_mask_blend_ps(0xaaaa, _mm512_set1_ps(p[0]), _mm512_set1_ps(p[1])); }
+            static type splat(float s) { return _mm512_set1_ps(s); }
+            static type mulv(type a, type b) { return _mm512_mul_ps(a, b); }
+        };
+#include "simd_kernels.h"
+    }
+SEL_SIMD_TARGET_END
+SEL_SIMD_AVX512_WARNINGS_END
+#endif
+
+    // real dot product of a and b, n reals each
+    template<typename T>T dot(const T *a, const T *b, unsigned n) {
+#if defined(SEL_SIMD_X86)
+        const auto i = active_isa();
+        if (i == isa::avx512)
+            return avx512::dot<T>(a, b, n);
+        if (i != isa::scalar)
+            return avx2::dot<T>(a, b, n);
+#endif
+        return scalar::dot<T>(a, b, n);
+    }
+
+    // one sample of a sliding DFT over n bins (see simd_kernels.h)
+    template<typename T>void sdft_update(T *re, T *im, const T *cr, const T *ci, unsigned n, T delta) {
+#if defined(SEL_SIMD_X86)
+        const auto i = active_isa();
+        if (i == isa::avx512)
+            return avx512::sdft_update<T>(re, im, cr, ci, n, delta);
+        if (i != isa::scalar)
+            return avx2::sdft_update<T>(re, im, cr, ci, n, delta);
+#endif
+        scalar::sdft_update<T>(re, im, cr, ci, n, delta);
+    }
+
+    // element-wise product of n reals, out[i] = a[i] * b[i]
+    template<typename T>void multiply(const T *a, const T *b, T *out, unsigned n) {
+#if defined(SEL_SIMD_X86)
+        const auto i = active_isa();
+        if (i == isa::avx512)
+            return avx512::multiply<T>(a, b, out, n);
+        if (i != isa::scalar)
+            return avx2::multiply<T>(a, b, out, n);
+#endif
+        scalar::multiply<T>(a, b, out, n);
+    }
+
+} // simd
@@ -0,0 +1,68 @@
+// NOTE: No include guard.  This file is included by simd.h once per instruction set,
+// inside a namespace which defines the vector type V<T> used by the kernels below.
+// They use V<T>::type as a vector of 2 * V<T>::width reals:  load(), store(), add(), sub(), splat() (broadcast a real)
+// and mulv() (element-wise multiply).
+
+////// dot
+// Real dot product of a and b (n reals each), with two vector accumulators (e.g. for the direct autocorrelation)
+
+template<typename T>
+T dot(const T *a, const T *b, unsigned n) {
+    using v = V<T>;
+    constexpr unsigned L = 2 * v::width;
+    const unsigned nv = n - n % (2 * L);
+    auto acc0 = v::splat(0);
+    auto acc1 = v::splat(0);
+    for (unsigned i = 0; i < nv; i += 2 * L) {
+        acc0 = v::add(acc0, v::mulv(v::load(a + i), v::load(b + i)));
+        acc1 = v::add(acc1, v::mulv(v::load(a + i + L), v::load(b + i + L)));
+    }
+    T lanes[L];
+    v::store(lanes, v::add(acc0, acc1));
+    T sum = 0;
+    for (unsigned l = 0; l < L; ++l)
+        sum += lanes[l];
+    for (unsigned i = nv; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+////// sdft_update
+// One sample of a sliding DFT, over n bins in structure-of-arrays layout:
+// X[k] = (X[k] + delta) * (cr[k] + i ci[k]), where delta is the newest sample minus the one leaving the window
+
+template<typename T>
+void sdft_update(T *re, T *im, const T *cr, const T *ci, unsigned n, T delta) {
+    using v = V<T>;
+    constexpr unsigned L = 2 * v::width;
+    const unsigned nv = n - n % L;
+    const auto d = v::splat(delta);
+    for (unsigned k = 0; k < nv; k += L) {
+        const auto r = v::add(v::load(re + k), d);
+        const auto i = v::load(im + k);
+        const auto c = v::load(cr + k);
+        const auto s = v::load(ci + k);
+        v::store(re + k, v::sub(v::mulv(r, c), v::mulv(i, s)));
+        v::store(im + k, v::add(v::mulv(r, s), v::mulv(i, c)));
+    }
+    for (unsigned k = nv; k < n; ++k) {
+        const T r = re[k] + delta;
+        const T i = im[k];
+        re[k] = r * cr[k] - i * ci[k];
+        im[k] = r * ci[k] + i * cr[k];
+    }
+}
+
+////// multiply
+// Element-wise product of n reals, out[i] = a[i] * b[i] (e.g. applying a window).  out may be a or b
+
+template<typename T>
+void multiply(const T *a, const T *b, T *out, unsigned n) {
+    using v = V<T>;
+    constexpr unsigned L = 2 * v::width;
+    const unsigned nv = n - n % L;
+    for (unsigned i = 0; i < nv; i += L)
+        v::store(out + i, v::mulv(v::load(a + i), v::load(b + i)));
+    for (unsigned i = nv; i < n; ++i)
+        out[i] = a[i] * b[i];
+}
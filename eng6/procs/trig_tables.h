@@ -0,0 +1,45 @@
+#pragma once
+/*
+    Compile-time sin/cos, for tables of twiddle factors (fft_impl.h) and window coefficients (window.h).
+    Tables up to max_constexpr_size points can be built at compile time;  larger ones would take too long to
+    evaluate in the compiler, and are built (by the same code) on first use.
+*/
+
+namespace trig_tables {
+
+    constexpr unsigned max_constexpr_size = 4096;
+
+    // sin(2*pi*k/n) and cos(2*pi*k/n).
+    // The angle is reduced to [0, pi/4] with exact integer arithmetic, so that the Taylor series converges quickly
+    constexpr void sincos_2pi(unsigned long long k, unsigned long long n, long double& s, long double& c) {
+        // angle = 2*pi*num/den
+        unsigned long long num = 8 * (k % n);
+        const unsigned long long den = 8 * n;
+        bool neg_s = false, neg_c = false, swap_sc = false;
+
+        if (2 * num > den) { num = den - num; neg_s = true; }       // angle in (pi, 2pi): use 2pi - angle
+        if (4 * num > den) { num = den / 2 - num; neg_c = true; }   // angle in (pi/2, pi]: use pi - angle
+        if (8 * num > den) { num = den / 4 - num; swap_sc = true; } // angle in (pi/4, pi/2]: use pi/2 - angle
+
+        const long double x = 2.0L * 3.14159265358979323846264338327950288L * num / den;
+        const long double x2 = x * x;
+        long double sin_x = 0, cos_x = 0;
+        long double ts = x, tc = 1;
+        for (unsigned i = 1; i <= 23; i += 2) {
+            sin_x += ts;
+            cos_x += tc;
+            ts *= -x2 / ((i + 1) * (i + 2));
+            tc *= -x2 / (i * (i + 1));
+        }
+
+        s = swap_sc ? cos_x : sin_x;
+        c = swap_sc ? sin_x : cos_x;
+        if (neg_s) s = -s;
+        if (neg_c) c = -c;
+    }
+
+    // fixed-size storage, that a constexpr lambda can fill and return
+    template<typename T, unsigned SZ>
+    struct array { T v[SZ]; };
+
+} // trig_tables
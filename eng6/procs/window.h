@@ -1,8 +1,11 @@
 #pragma once
 #include "../eng_traits.h"
 #include "../processor.h"
+#include "simd.h"
+#include "trig_tables.h"
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <vector>
 namespace sel {
 	namespace eng6 {
 		namespace proc {
@@ -10,14 +13,54 @@ namespace sel {
 
 			namespace wintype {
 
+				// Window coefficient tables, one per window type and size, shared by every window and built once.
+				// Cosine windows (a0 - a1 cos(2 pi i / N)) up to trig_tables::max_constexpr_size points are built at compile time,
+				// with the constexpr sin/cos of trig_tables.h.  Larger ones, and kaiser windows, are built on first use;
+				// function-local statics, so that is thread-safe.
+				// Each window type has process_buffer(in, out), the whole window, and process_span(in, out, first, count),
+				// coefficients first .. first+count-1 only (for frames that wrap around a ring buffer).
+				namespace tables {
+					template<class C>constexpr void fill_cosine(samp_t* w, size_t n)
+					{
+						for (size_t i = 0; i < n; ++i) {
+							long double s = 0, c = 0;
+							trig_tables::sincos_2pi(i, n, s, c);
+							w[i] = static_cast<samp_t>(C::a0 - C::a1 * c);
+						}
+					}
+
+					template<class C, size_t N>inline const samp_t* cosine()
+					{
+						if constexpr (N <= trig_tables::max_constexpr_size) {
+							static constexpr auto table = [] {
+								trig_tables::array<samp_t, N> w{};
+								fill_cosine<C>(w.v, N);
+								return w;
+							}();
+							return table.v;
+						} else {
+							static const std::vector<samp_t> table = [] {
+								std::vector<samp_t> w(N);
+								fill_cosine<C>(w.data(), N);
+								return w;
+							}();
+							return table.data();
+						}
+					}
+
+					// in * coeffs, count values
+					inline void apply(const samp_t* coeffs, const samp_t* in, samp_t* out, size_t count)
+					{
+						simd::multiply(in, coeffs, out, static_cast<unsigned>(count));
+					}
+				}
+
 				template<typename traits>struct KAISER
 				{
-
-					template<size_t Order = traits::input_frame_size>static double kaiser(size_t idx)
+					template<size_t Order = traits::input_frame_size>static const samp_t* coefficients()
 					{
-						static auto initialized = false;
-						static std::array<double, Order>coeffs = { -1 };
-						if (!initialized) {
+						static const std::vector<samp_t> coeffs = [] {
+							std::vector<samp_t> coeffs(Order);
 							constexpr double bta = traits::kaiser_beta;
 
 							double bes = fabs(boost::math::cyl_bessel_i(0, bta));
@@ -43,37 +86,61 @@ namespace sel {
 								coeffs[j++] = fabs(w[i]);
 
 							assert(j == Order);
-							initialized = true;
-						}
-						return coeffs[idx];
+							return coeffs;
+						}();
+						return coeffs.data();
 					}
 
-					template<size_t Winsize = traits::input_frame_size>static void process_buffer(const samp_t* in, samp_t* out)
+					template<size_t Order = traits::input_frame_size>static double kaiser(size_t idx)
 					{
+						return coefficients<Order>()[idx];
+					}
 
-						for (size_t i = 0; i < Winsize; ++i)
-							out[i] = in[i] * kaiser(i);
-
+					template<size_t Winsize = traits::input_frame_size>static void process_buffer(const samp_t* in, samp_t* out)
+					{
+						tables::apply(coefficients<Winsize>(), in, out, Winsize);
+					}
+					template<size_t Winsize = traits::input_frame_size>static void process_span(const samp_t* in, samp_t* out, size_t first, size_t count)
+					{
+						tables::apply(coefficients<Winsize>() + first, in, out, count);
 					}
 					static const char* name() { return  "kaiser_window"; }
 
 				};
 				template<typename traits>struct HAMMING {
-					template<size_t Winsize = traits::input_frame_size>static void process_buffer(const samp_t* in, samp_t* out)
+					struct cosine_terms { static constexpr long double a0 = 0.54L, a1 = 0.46L; };
+
+					template<size_t Winsize = traits::input_frame_size>static const samp_t* coefficients()
 					{
-						for (size_t i = 0; i < Winsize; ++i)
-							out[i] = in[i] * (0.54 - 0.46 * cos((2.0 * M_PI * i) / Winsize));
+						return tables::cosine<cosine_terms, Winsize>();
+					}
 
+					template<size_t Winsize = traits::input_frame_size>static void process_buffer(const samp_t* in, samp_t* out)
+					{
+						tables::apply(coefficients<Winsize>(), in, out, Winsize);
+					}
+					template<size_t Winsize = traits::input_frame_size>static void process_span(const samp_t* in, samp_t* out, size_t first, size_t count)
+					{
+						tables::apply(coefficients<Winsize>() + first, in, out, count);
 					}
 					static const char* name() { return "hamming_window"; }
 
 				};
 				template<typename traits>struct HANN {
-					template<size_t Winsize = traits::input_frame_size>static void process_buffer(const samp_t* in, samp_t* out)
+					struct cosine_terms { static constexpr long double a0 = 0.5L, a1 = 0.5L; };
+
+					template<size_t Winsize = traits::input_frame_size>static const samp_t* coefficients()
 					{
-						for (size_t i = 0; i < Winsize; ++i)
-							out[i] = in[i] * (0.5 - 0.5 * cos((2.0 * M_PI * i) / Winsize));
+						return tables::cosine<cosine_terms, Winsize>();
+					}
 
+					template<size_t Winsize = traits::input_frame_size>static void process_buffer(const samp_t* in, samp_t* out)
+					{
+						tables::apply(coefficients<Winsize>(), in, out, Winsize);
+					}
+					template<size_t Winsize = traits::input_frame_size>static void process_span(const samp_t* in, samp_t* out, size_t first, size_t count)
+					{
+						tables::apply(coefficients<Winsize>() + first, in, out, count);
 					}
 					static const char* name() { return "hann_window"; }
 
@@ -81,10 +148,15 @@ namespace sel {
 				template<typename traits>struct RECTANGULAR {
 					template<size_t Winsize = traits::input_frame_size>static void process_buffer(const samp_t* in, samp_t* out)
 					{
-						for (size_t i = 0; i < Winsize; ++i)
-							out[i] = in[i];
+						if (in != out)
+							std::copy(in, in + Winsize, out);
 
 					}
+					template<size_t Winsize = traits::input_frame_size>static void process_span(const samp_t* in, samp_t* out, size_t /*first*/, size_t count)
+					{
+						if (in != out)
+							std::copy(in, in + count, out);
+					}
 					static const char* name() { return "rectangular_window"; }
 
 				};
@@ -119,34 +191,44 @@ namespace sel {
 
 
 			};
+			// Overlapped window.  Input samples are written once into a ring buffer, and each frame is a view into the ring:
+			// the output processor applies the window reading straight from the ring (in two spans if the frame wraps)
+			// and writing into its output port.  The output schedule is invoked synchronously from the input processor,
+			// once per frame, so the view is always current.
 			template<typename traits, typename wintype, size_t input_sz> class window_t<traits, wintype, input_sz, true> :
 				public data_source<traits::input_frame_size>, virtual public creatable<window_t<traits, wintype, input_sz>>
 			{
 				static constexpr size_t output_sz = traits::input_frame_size;
 				static_assert(traits::overlap < output_sz, "Window overlap must be less than window size.");
+				static constexpr size_t hop = output_sz - traits::overlap;
+				// after a frame is taken, fewer than output_sz samples are unread, so there is always room for another input_sz
+				static constexpr size_t ring_sz = output_sz + input_sz;
 			public:
-				using fifo = quick_queue<samp_t, output_sz>;
-				fifo fifo_;
+				std::vector<samp_t> ring_ = std::vector<samp_t>(ring_sz);
+				size_t put_ = 0;		// next sample written
+				size_t frame_ = 0;		// first sample of the current frame
+				size_t avail_ = 0;		// unread samples from frame_
 				// At init time, this is set by the output processor
 				schedule* output_context = nullptr;
 
 				struct in_proc_t : Processor1A0<input_sz>
 				{
-					using input_buf = quick_queue<samp_t, 2 * std::max(input_sz, output_sz)>;
-					input_buf input_buf_;
-
-					wintype impl_;
 					window_t* owner;
 					explicit in_proc_t(window_t* o) : owner(o) {}
 
 					void process() final {
-						input_buf_.atomicwrite(this->in, input_sz);
-						while (input_buf_.get_avail() >= output_sz)
+						auto& o = *owner;
+						const size_t first = std::min(input_sz, ring_sz - o.put_);
+						std::copy(this->in, this->in + first, o.ring_.data() + o.put_);
+						std::copy(this->in + first, this->in + input_sz, o.ring_.data());
+						o.put_ = (o.put_ + input_sz) % ring_sz;
+						o.avail_ += input_sz;
+
+						while (o.avail_ >= output_sz)
 						{
-							impl_.process_buffer(input_buf_.atomicread(output_sz - traits::overlap), owner->fifo_.acquirewrite());
-							owner->fifo_.endwrite(output_sz);
-							owner->output_context->invoke();
-
+							o.output_context->invoke();
+							o.frame_ = (o.frame_ + hop) % ring_sz;
+							o.avail_ -= hop;
 						}
 
 					}
@@ -155,7 +237,7 @@ namespace sel {
 						if (context->trigger() == owner)
 							throw eng_ex("Window input can't triggered by the window itself.");
 
-						owner->set_rate(context->expected_rate() * rate_t(output_sz, output_sz - traits::overlap));
+						owner->set_rate(context->expected_rate() * rate_t(output_sz, hop));
 					}
 
 				} input_;
@@ -166,11 +248,16 @@ namespace sel {
 					if (context->trigger() != this)
 						throw eng_ex("Window output must be triggered by the window itself.");
 					this->output_context = context;
+					context->set_invoked();
 				}
 
 				void process() final
 				{
-					this->fifo_.atomicread_into(this->oport);
+					const samp_t* ring = ring_.data();
+					const size_t first = std::min(output_sz, ring_sz - frame_);
+					wintype::template process_span<output_sz>(ring + frame_, this->out, 0, first);
+					if (first < output_sz)
+						wintype::template process_span<output_sz>(ring, this->out + first, first, output_sz - first);
 				}
 
 
@@ -3,6 +3,7 @@
 
 // window unit test
 #include "window.h"
+#include "fft.h"
 //#include "wav_file_data_source.h"
 #include "compound_processor.h"
 #include "../scheduler.h"
@@ -25,6 +26,12 @@ struct ut_traits_overlap
 	static constexpr size_t input_fs = 16000;
 };
 
+struct fft_traits
+{
+	static constexpr size_t input_frame_size = 64;
+	static constexpr size_t overlap = 0;
+};
+
 struct ut_traits
 {
 	static constexpr size_t input_fs = 16000;
@@ -86,6 +93,52 @@ void run() {
 	
 
 
+	// coefficient tables against the formulas
+	SEL_UNIT_TEST_ITEM("hamming table");
+	hamming_window hamming_window;
+	hamming_window.ConnectFrom(input);
+	hamming_window.freeze();
+	hamming_window.process();
+	for (size_t i = 0; i < N; ++i)
+		SEL_UNIT_TEST_ASSERT_ALMOST_EQUAL(hamming_window.out[i], 0.54 - 0.46 * cos((2.0 * M_PI * i) / N));
+
+	SEL_UNIT_TEST_ITEM("hann table");
+	{
+		using hann = sel::eng6::proc::wintype::HANN<ut_traits>;
+		const auto* hann1024 = hann::coefficients<1024>();	// built at compile time
+		const auto* hann8192 = hann::coefficients<8192>();	// built on first use
+		SEL_UNIT_TEST_ASSERT(hann1024 == hann::coefficients<1024>());
+		for (size_t i = 0; i < 1024; ++i)
+			SEL_UNIT_TEST_EQUAL_THRESH(hann1024[i], 0.5 - 0.5 * cos((2.0 * M_PI * i) / 1024), 1e-15);
+		for (size_t i = 0; i < 8192; i += 7)
+			SEL_UNIT_TEST_EQUAL_THRESH(hann8192[i], 0.5 - 0.5 * cos((2.0 * M_PI * i) / 8192), 1e-15);
+	}
+
+	// window straight into the fft buffer:  same as window then fftr
+	SEL_UNIT_TEST_ITEM("windowed fftr");
+	{
+		using hann = sel::eng6::proc::wintype::HANN<fft_traits>;
+		std::vector<double> x(fft_traits::input_frame_size);
+		for (size_t i = 0; i < x.size(); ++i)
+			x[i] = sin(0.3 * i) + 0.25 * cos(1.7 * i);
+		sel::eng6::Const signal = x;
+
+		sel::eng6::proc::window_t<fft_traits, hann, fft_traits::input_frame_size> window1;
+		sel::eng6::proc::fftr_t<fft_traits> fftr1;
+		sel::eng6::proc::windowed_fftr_t<fft_traits, hann> windowed_fftr1;
+		window1.ConnectFrom(signal);
+		window1.ConnectTo(fftr1);
+		windowed_fftr1.ConnectFrom(signal);
+		window1.freeze();
+		fftr1.freeze();
+		windowed_fftr1.freeze();
+		window1.process();
+		fftr1.process();
+		windowed_fftr1.process();
+		for (size_t i = 0; i < 2 * (fft_traits::input_frame_size / 2 + 1); ++i)
+			SEL_UNIT_TEST_ASSERT(windowed_fftr1.out[i] == fftr1.out[i]);
+	}
+
 	//sel::eng6::proc::sample::Logger logger;
 	struct null_sink : sel::eng6::Processor1A0<ut_traits_overlap::input_frame_size>
 	{
@@ -129,6 +182,58 @@ void run() {
 		SEL_UNIT_TEST_ASSERT(static_cast<size_t>(rectangular_window.out[0] + 0.5) % hop_length == 0);
 	}
 
+	// frames are views into the ring buffer:  input blocks of 4, frames of 10 every 7 samples, so frames wrap the ring
+	SEL_UNIT_TEST_ITEM("overlap window frames");
+	{
+		static constexpr size_t frame_sz = ut_traits_overlap::input_frame_size;
+		using hann = sel::eng6::proc::wintype::HANN<ut_traits_overlap>;
+		sel::eng6::proc::window_t<ut_traits_overlap, hann, 4> hann_window;
+
+		struct ramp4 : sel::eng6::Processor01A<4>
+		{
+			size_t c = 0;
+			void process() final
+			{
+				for (size_t i = 0; i < 4; ++i)
+					out[i] = static_cast<samp_t>(c++);
+			}
+		} ramp;
+
+		struct frame_check : sel::eng6::Processor1A0<frame_sz>
+		{
+			size_t frames = 0;
+			size_t errors = 0;
+			void process() final
+			{
+				const auto* w = hann::coefficients<frame_sz>();
+				for (size_t i = 0; i < frame_sz; ++i)
+					if (in[i] != static_cast<samp_t>(frames * hop_length + i) * w[i])
+						++errors;
+				++frames;
+			}
+		} check;
+
+		const auto ramp_rate = rate_t(ut_traits_overlap::input_fs, 4);
+		sel::eng6::semaphore ramp_sem(0, ramp_rate);
+		sel::eng6::proc::compound_processor ramp_proc;
+		sel::eng6::proc::compound_processor check_proc;
+		ramp_proc.connect_procs(ramp, hann_window.input_proc());
+		check_proc.connect_procs(hann_window.output_proc(), check);
+
+		sel::eng6::scheduler s2 = {};
+		sel::eng6::schedule ramp_schedule(&ramp_sem, ramp_proc);
+		sel::eng6::schedule check_schedule(&hann_window, check_proc);
+		ramp_sem.raise(50);
+		s2.add(ramp_schedule);
+		s2.add(check_schedule);
+		s2.init();
+		while (s2.step())
+			;
+		// 200 samples: (200 - 10) / 7 + 1 frames
+		SEL_UNIT_TEST_ASSERT(check.frames == (50 * 4 - frame_sz) / hop_length + 1);
+		SEL_UNIT_TEST_ASSERT(check.errors == 0);
+	}
+
 
 }
 
@@ -2,7 +2,11 @@
 #include <vector>
 #include <exception>
 #include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
 #include "idx.h"
+#include "mirrored_buffer.h"
 #include <iostream>
 
 namespace sel {
@@ -33,6 +37,15 @@ namespace sel {
 
 	GUARANTEED_SINGLE_THREADED should be set to true for single-threaded scenarios,
 	which gives a slight performance improvement.
+	With it false, the locks only detect overlapping calls (and drop data): quick_queue is not a
+	cross-thread queue.  To pass data between two threads, use spsc_queue (spsc_queue.h), which has the same interface.
+
+	Storage:  reads and writes of up to size() elements are always contiguous in memory.
+	If the queue's bytes are a multiple of the page size (and T is trivially copyable), the storage is a
+	mirrored_buffer, whose pages are mapped twice back to back, so every element is stored once and no wrap-around
+	copies are needed.  Otherwise (small or odd-sized queues, or no OS support), it is a vector twice the size,
+	with the second half kept as a copy of the first.
+	atomicwrite() and atomicread_into() copy in at most two blocks (memcpy for trivially copyable T).
 
 
 	*/
@@ -80,8 +93,12 @@ namespace sel {
 	{
 		friend class quick_queue_ut::test;
 
-		std::vector<T> buf;
-		//T *buf;		// Data is stored in a simple array, twice as big as we need
+		static constexpr bool can_mirror = std::is_trivially_copyable<T>::value;
+
+		mirrored_buffer mirror;	// storage if mirrored
+		std::vector<T> vbuf;	// storage otherwise:  a simple array, twice as big as we need
+		T *buf = nullptr;		// whichever is in use
+		bool mirrored = false;
 		idx<SZ> p;	// put() idx
 		idx<SZ> g;	// get() idx
 		size_t n;	// count of items in buf
@@ -89,6 +106,16 @@ namespace sel {
 		quick_queue_lock<GUARANTEED_SINGLE_THREADED>rLock;
 		quick_queue_lock<GUARANTEED_SINGLE_THREADED>wLock;
 
+		static void copy_(const T *from, size_t howmany, T *to)
+		{
+			if (!howmany)
+				return;
+			if constexpr (std::is_trivially_copyable<T>::value)
+				std::memcpy(to, from, howmany * sizeof(T));
+			else
+				std::copy(from, from + howmany, to);
+		}
+
 	public:
 		constexpr size_t size() const { return p.size(); }
 
@@ -106,10 +133,25 @@ namespace sel {
 			else if (capacity == 0)
 				throw std::runtime_error("Quick queue capacity cannot be 0");
 			
-			buf.resize(2 * size());
+			if (can_mirror && mirrored_buffer::supported(size() * sizeof(T))) {
+				try {
+					mirror = mirrored_buffer(size() * sizeof(T));
+					buf = static_cast<T *>(mirror.data());
+					mirrored = true;
+				} catch (std::runtime_error&) {
+					// fall back to the vector
+				}
+			}
+			if (!mirrored) {
+				vbuf.resize(2 * size());
+				buf = vbuf.data();
+			}
 
 		}
 
+		// true if the storage is a mirrored_buffer
+		bool is_mirrored() const { return mirrored; }
+
 		void put(const T& v)
 		{
 
@@ -118,7 +160,8 @@ namespace sel {
 
 			if (!wLock.lock()) {
 				++n;
-				buf[p + size()] = v;
+				if (!mirrored)
+					buf[p + size()] = v;
 				buf[p++] = v;
 				wLock.unlock();
 			}
@@ -138,12 +181,18 @@ namespace sel {
 					throw std::runtime_error("atomicwrite: cannot write all requested data");
 
 				if (!wLock.lock()) {
-					while (howmany--) {
-						++n;
-						buf[p + size()] = *data;
-						buf[p++] = *data++;
-
+					if (mirrored)
+						copy_(data, howmany, buf + p);
+					else {
+						// the written span and its copy in the other half, each in at most two pieces
+						const size_t first = std::min(howmany, size() - p);
+						copy_(data, first, buf + p);
+						copy_(data, first, buf + p + size());
+						copy_(data + first, howmany - first, buf);
+						copy_(data + first, howmany - first, buf + size());
 					}
+					n += howmany;
+					p += howmany;
 					wLock.unlock();
 				} else {
 					throw std::runtime_error("atomicwrite: locked");
@@ -195,13 +244,15 @@ namespace sel {
 					throw std::runtime_error("endwrite: cannot write all requested data");
 				n += howmany;
 
-				// some data may overrun the buffer, find out how much
-				auto pp = static_cast<size_t>(p) + howmany;
-				auto overrun = (pp <= size()) ? 0 : pp - size()+1;
-				// now copy the extra to the beginning of the buffer
+				if (!mirrored) {
+					// some data may overrun the buffer, find out how much
+					auto pp = static_cast<size_t>(p) + howmany;
+					auto overrun = (pp <= size()) ? 0 : pp - size()+1;
+					// now copy the extra to the beginning of the buffer
 
-				while (overrun--)
-					buf[overrun] = buf[pp--];
+					while (overrun--)
+						buf[overrun] = buf[pp--];
+				}
 
 				p += (int)howmany;
 
@@ -227,12 +278,29 @@ namespace sel {
 			auto howmany = last - first;
 			
 			auto data = acquireread();
-			if (data)
+			if (data) {
+				// the span is contiguous: copy it before endread() moves (or, if not mirrored, rewrites) it
+				if (get_avail() < static_cast<size_t>(howmany)) {
+					rLock.unlock();
+					throw std::runtime_error("atomicread_into: cannot read all requested data");
+				}
+				std::copy(data, data + howmany, first);
 				endread(howmany);
-			do {
-				*first++ = *data++;
-			} while (first != last);
+			}
+
+		}
 
+		void atomicread_into(T *dest, size_t howmany)
+		{
+			auto data = acquireread();
+			if (data) {
+				if (get_avail() < howmany) {
+					rLock.unlock();
+					throw std::runtime_error("atomicread_into: cannot read all requested data");
+				}
+				copy_(data, howmany, dest);
+				endread(howmany);
+			}
 		}
 
 		template<typename Iterable>void atomicread_into(Iterable& dest)
@@ -248,7 +316,7 @@ namespace sel {
 			// some data may have be requested past the physical end of the buffer.
 			// find out how much
 			size_t gg = (size_t)g + howmany;
-			size_t overrun = (gg <= size()) ? 0 : gg - size()+1;
+			size_t overrun = (mirrored || gg <= size()) ? 0 : gg - size()+1;
 			g += (int)howmany;
 			// now copy the beginning of the buffer to the extra
 	
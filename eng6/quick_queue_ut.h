@@ -4,6 +4,7 @@
 #include "quick_queue.h"
 #include <algorithm>
 #include <array>
+#include <vector>
 #include "unit_test.h"
 SEL_UNIT_TEST(quick_queue)
 
@@ -97,6 +98,34 @@ void run()
 
 
 
+		// a page-multiple queue is mirrored (on Linux):  spans that wrap around are contiguous, each element stored once
+		SEL_UNIT_TEST_ITEM("mirrored");
+		constexpr size_t mirrored_size = 4096 / sizeof(ut_traits::item_type);
+		sel::quick_queue<ut_traits::item_type, mirrored_size> q5;
+		sel::quick_queue<ut_traits::item_type> q6(mirrored_size);
+#if defined(__linux__)
+		SEL_UNIT_TEST_ASSERT(q5.is_mirrored());
+		SEL_UNIT_TEST_ASSERT(q6.is_mirrored());
+#endif
+		SEL_UNIT_TEST_ASSERT(!q1.is_mirrored());
+
+		std::vector<ut_traits::item_type> big(mirrored_size - 3), big_check;
+		for (size_t i = 0; i < 50; ++i) {
+			std::generate(big.begin(), big.end(), [&]() { return static_cast<ut_traits::item_type>(c++); });
+			big_check = big;
+			q5.atomicwrite(big);
+			std::fill(big.begin(), big.end(), 0);
+			q5.atomicread_into(big.data(), big.size());
+			SEL_UNIT_TEST_ASSERT(big == big_check);
+
+			// async write straight into the ring, across the end
+			auto *p = q6.acquirewrite();
+			std::copy(big_check.begin(), big_check.end(), p);
+			q6.endwrite(big_check.size());
+			const auto *r = q6.atomicread(big_check.size());
+			SEL_UNIT_TEST_ASSERT(std::equal(big_check.begin(), big_check.end(), r));
+		}
+
 	} catch (std::runtime_error &ex) {
 		std::cout << ex.what() << std::endl;
 	}
@@ -51,5 +51,9 @@ namespace sel {
 			//	begin_sampling();
 		}
 
+		void iterate(counter_t n) const {
+			_iters += n;
+		}
+
 	};
 } // sel
\ No newline at end of file
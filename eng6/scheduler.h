@@ -2,6 +2,10 @@
 #define SCHEDULER_H_INCLUDED
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "singleton.h"
 #include "processor.h"
 #include "event.h"
@@ -46,6 +50,19 @@ namespace sel {
 
 			}
 
+			// Wait until a callback is ready (a timer expires, an I/O completes, work is queued), and run it, or until timeout.
+			// Returns the number of callbacks that were run
+			size_t run_one_for(std::chrono::nanoseconds timeout)
+			{
+				io_context& ioc = context.get();
+				// poll() stops the context when it runs out of work:  it must be restarted before it will wait
+				if (ioc.stopped())
+					ioc.restart();
+				// don't return early because there is no work:  something may queue some (stop() does)
+				auto guard = boost::asio::make_work_guard(ioc);
+				return ioc.run_one_for(timeout);
+			}
+
 
 			boost::asio::io_context& ioc() { return context.get(); }
 		};
@@ -176,10 +193,34 @@ namespace sel {
 			function_object f_;
 			functor& action_;
 
+			// block processing:  the most ticks run by one call of the action, and the action if it runs blocks
+			size_t max_block_ = 1;
+			processor *block_action_ = nullptr;
+
+			// for a multi-threaded scheduler:  see set_invoked() and set_io_bound()
+			bool invoked_ = false;
+			bool io_bound_ = false;
+
 		public:
 			auto trigger() const { return trigger_; }
 			auto& action() const { return action_; }
 
+			// The action is only run by invoke(), synchronously from another schedule's action (the input of a resampler,
+			// window, mux/demux or fan_in calls it), so always on that schedule's thread.  Set at init by the output processor.
+			// A multi-threaded scheduler doesn't give the schedule a worker of its own.
+			void set_invoked() { invoked_ = true; }
+			bool invoked() const { return invoked_; }
+
+			// The action shares state with async I/O completion handlers (a stream reader's buffer), so it must run on the
+			// thread that services async I/O:  worker 0 of a multi-threaded scheduler.  Set at init.
+			void set_io_bound() { io_bound_ = true; }
+			bool io_bound() const { return io_bound_; }
+
+			// ticks per call if the action runs blocks, 1 if not (or not initialized yet)
+			size_t block() const { return block_action_ ? max_block_ : 1; }
+			// most ticks to run per call of a block capable action.  Set before init()
+			void set_block(size_t n) { max_block_ = n ? n : 1; }
+
 			virtual std::ostream& trace(std::ostream& os) const override
 
 			{
@@ -188,9 +229,10 @@ namespace sel {
 			}
 
 
-			schedule(semaphore* trigger, functor& action_) :
+			schedule(semaphore* trigger, functor& action_, size_t max_block = 1) :
 				trigger_(trigger),
-				action_(action_) {}
+				action_(action_),
+				max_block_(max_block ? max_block : 1) {}
 
 			schedule(semaphore* trigger_, func f) :
 				trigger_(trigger_),
@@ -199,10 +241,22 @@ namespace sel {
 
 			size_t acquire() const { return trigger_->acquire(); }
 
+			// acquire as many ticks as one call of the action can run (at most block())
+			size_t acquire_block() const { return trigger_->acquire(block()); }
+
+			// run n acquired ticks
+			void run(size_t n)
+			{
+				if (n > 1)
+					block_action_->process_block(n);
+				else
+					action_();
+			}
+
 			void invoke(size_t repeat_count = 1U) {
 				trigger_->raise(repeat_count);
-				while (trigger_->acquire())
-					action_();
+				while (size_t n = acquire_block())
+					run(n);
 
 			}
 
@@ -212,9 +266,17 @@ namespace sel {
 				if (auto* pt = dynamic_cast<periodic_event*>(trigger_))
 					pt->init();
 
+				// size the ports for blocks before they are frozen
+				auto cp = dynamic_cast<ConnectableProcessor*>(&action_);
+				const bool blocks = max_block_ > 1 && cp && cp->block_capable();
+				if (blocks)
+					cp->set_block_frames(max_block_);
+
 				auto c = dynamic_cast<freezeable*>(&action_);
 				if (c) c->freeze();
 
+				block_action_ = blocks && cp->block_ready(max_block_) ? cp : nullptr;
+
 				auto p = dynamic_cast<processor*>(&action_);
 
 				if (p) p->init(this);
@@ -232,6 +294,41 @@ namespace sel {
 			rate_t expected_rate() const { return trigger_->rate().expected(); }
 
 		};
+		/*
+		What scheduler::run() does when a pass finds nothing to run:  no async callbacks were pending, and no schedule's trigger
+		was raised.
+		spin:			start the next pass at once.  Lowest wake-up latency, but the scheduler's thread uses a whole core.
+		spin_then_park:	spin for spin_passes idle passes, then park.  Busy streams keep spin latency, idle ones don't burn a core.
+		block:			park at once:  the thread sleeps whenever there is nothing to do.
+
+		Parking waits on the asio io_context until a callback is ready (a periodic_event's timer, an I/O completion, queued work),
+		or for at most park_timeout.  Triggers are raised by such callbacks (or by actions run by the scheduler), so nothing
+		is missed while parked.
+		*/
+		enum class idle_policy { spin, spin_then_park, block };
+
+		/*
+		Multi-threaded running (set_threads(n), n > 1):  run() partitions the schedules onto n worker threads, and runs
+		each worker's schedules in the order they were added, as the single-threaded scheduler does.  Unless work is
+		stolen (below), a schedule always runs on the same worker, so each fiber's ticks run in order.
+		- Worker 0 is the thread that called run().  It also services async I/O, so timer and I/O completion handlers run
+		  on it.  Schedules whose actions share state with those handlers (stream readers:  see schedule::set_io_bound())
+		  go to worker 0.  The others are dealt out to the workers in turn.
+		- A fiber fed by a resampler, window, mux/demux or fan_in is invoked synchronously by the action feeding it
+		  (schedule::set_invoked()), so it runs on that action's worker, and the hand-off never crosses threads.
+		  To merge fibers from several workers into one, use a fan_in.
+		- Each worker has its own ready list.  Semaphores attached to it are raised with atomic read-modify-writes, so a
+		  handler on worker 0 can raise another worker's trigger, and wake that worker if it is parked.
+		Fibers must not otherwise share processors or ports.
+
+		Work stealing (set_work_stealing()):  the static partition balances badly when the fibers' loads are uneven or
+		bursty.  With work stealing, a worker that finds nothing ready on its own list runs one ready schedule from
+		another worker's list (one block of ticks), then looks at its own list again.  A schedule is claimed before it is run, so
+		a fiber never runs on two workers at once, and its ticks still run in order, though not always on the same thread.
+		I/O bound schedules are never stolen.  A worker leaving ticks pending wakes one parked worker to help (worker 0,
+		parked waiting for async I/O, by posting it a no-op callback).
+		*/
+
 		class scheduler : public singleton<scheduler>
 		{
 
@@ -239,10 +336,43 @@ namespace sel {
 
 			std::atomic_bool stop_request;
 
+			idle_policy idle_policy_ = idle_policy::spin;
+			size_t spin_passes_ = 10000;
+			std::chrono::nanoseconds park_timeout_ = std::chrono::milliseconds(100);
+			size_t idle_passes_ = 0;
+
+			size_t threads_ = 1;
+
+			// a worker thread of a multi-threaded run:  its schedules, indexed by their slots in its ready list
+			struct worker_t
+			{
+				const size_t index;
+				std::shared_ptr<ready_list> ready = std::make_shared<ready_list>(true);
+				std::vector<schedule*> slots;
+				// work stealing:  set while a worker is running the slot's schedule
+				std::unique_ptr<std::atomic<bool>[]> running;
+				size_t idle_passes = 0;
+				explicit worker_t(size_t index) : index(index) {}
+			};
+			bool work_stealing_ = false;
+			// worker 0 parks in the async I/O service, not on its ready list:  set while it does, so a thief can be woken there
+			std::atomic<bool> io_worker_parked_{ false };
+			std::vector<std::unique_ptr<worker_t>> workers_;
+			// stop() wakes the workers, perhaps from another thread
+			std::mutex workers_mutex_;
+
 			std::vector<schedule> schedules;
+			// schedules whose triggers have been raised, by index in schedules
+			std::shared_ptr<ready_list> ready_ = std::make_shared<ready_list>();
 
 			schedule *current_context_ = nullptr;
 
+			void attach_(semaphore *trigger)
+			{
+				ready_->resize(schedules.size());
+				trigger->attach(ready_, schedules.size() - 1);
+			}
+
 
 			// Returns the number of callbacks that were run
 			size_t service_all_pending_aio()
@@ -259,6 +389,214 @@ namespace sel {
 #endif
 			}
 
+			// Wait for an async callback, and run it
+			size_t park()
+			{
+#ifdef USE_ASIO
+				return asio_scheduler::get().run_one_for(park_timeout_);
+#else
+#ifdef _WIN32
+				const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(park_timeout_).count();
+				return ::SleepEx(static_cast<DWORD>(ms), TRUE) == WAIT_IO_COMPLETION ? 1 : 0;
+#endif
+#endif
+			}
+
+			// a pass of run() found nothing to do.  w is the worker, or nullptr if single-threaded
+			void idle(size_t& idle_passes, worker_t *w)
+			{
+				switch (idle_policy_) {
+				case idle_policy::spin:
+					return;
+				case idle_policy::spin_then_park:
+					if (++idle_passes < spin_passes_)
+						return;
+					break;
+				case idle_policy::block:
+					break;
+				}
+				idle_passes = 0;
+				if (services_io_(w)) {
+					if (w)
+						io_worker_parked_.store(true, std::memory_order_seq_cst);
+					park();
+					if (w)
+						io_worker_parked_.store(false, std::memory_order_relaxed);
+				}
+				else
+					w->ready->park(park_timeout_);
+			}
+
+			bool services_io_(const worker_t *w) const { return !w || w == workers_[0].get(); }
+
+			// give the schedules to the workers
+			void partition_()
+			{
+				std::lock_guard<std::mutex> lock(workers_mutex_);
+				workers_.clear();
+				for (size_t k = 0; k < threads_; ++k)
+					workers_.push_back(std::make_unique<worker_t>(k));
+				size_t next = 0;
+				for (auto& s : schedules) {
+					if (s.invoked()) {
+						// raised and acquired by invoke(), on the invoking worker
+						s.trigger_->attach(nullptr, 0);
+						continue;
+					}
+					worker_t& w = *workers_[s.io_bound() ? 0 : next++ % threads_];
+					w.slots.push_back(&s);
+					w.ready->resize(w.slots.size());
+					s.trigger_->attach(w.ready, w.slots.size() - 1);
+				}
+				for (auto& w : workers_) {
+					w->running.reset(new std::atomic<bool>[w->slots.size()]);
+					for (size_t i = 0; i < w->slots.size(); ++i)
+						w->running[i].store(false, std::memory_order_relaxed);
+				}
+			}
+
+			// Run the schedule in slot i of worker w's ready list, whose bit has just been taken, by the worker that owns it
+			// or (work stealing) by a thief.  Returns the number of actions run.
+			// With work stealing a schedule is claimed first, so it never runs on two workers at once;  if it can't be claimed
+			// (or a thief finds it must run on the I/O worker) its bit is set again, for its owner or a later pass.
+			size_t run_slot_(worker_t& w, size_t i, bool stealing)
+			{
+				auto& s = *w.slots[i];
+				ready_list& ready = *w.ready;
+				if (work_stealing_ && ((stealing && s.io_bound()) || w.running[i].exchange(true, std::memory_order_acquire))) {
+					ready.set(i);
+					return 0;
+				}
+				const size_t n = s.acquire_block();
+				if (n)
+					s.run(n);
+				if (work_stealing_)
+					w.running[i].store(false, std::memory_order_release);
+				// still ready if the count wasn't all taken:  with work stealing, an idle worker can take some of it
+				if (s.trigger_->pending()) {
+					ready.set(i);
+					if (work_stealing_)
+						wake_a_thief_(w);
+				}
+				return n ? 1 : 0;
+			}
+
+			// as step(), for one worker
+			size_t step_(worker_t& w)
+			{
+				size_t n_actions_run = 0;
+				ready_list& ready = *w.ready;
+				for (size_t i = ready.take(0); i != ready_list::npos; i = ready.take(i + 1))
+					n_actions_run += run_slot_(w, i, false);
+				return n_actions_run;
+			}
+
+			// work stealing:  run one ready schedule of another worker, trying the others in turn.  Returns the number run
+			size_t steal_(worker_t& thief)
+			{
+				const size_t n_workers = workers_.size();
+				for (size_t j = 1; j < n_workers; ++j) {
+					worker_t& victim = *workers_[(thief.index + j) % n_workers];
+					ready_list& ready = *victim.ready;
+					for (size_t i = ready.take(0); i != ready_list::npos; i = ready.take(i + 1))
+						if (run_slot_(victim, i, true))
+							return 1;
+				}
+				return 0;
+			}
+
+			// work stealing:  w has a backlog, so wake a parked worker to steal some:  one parked on its own (empty) ready
+			// list, or worker 0, parked waiting for async I/O
+			void wake_a_thief_(const worker_t& w)
+			{
+				for (auto& v : workers_) {
+					if (v.get() == &w)
+						continue;
+					if (v.get() == workers_[0].get()) {
+#ifdef USE_ASIO
+						// a no-op callback ends the wait.  Only the first thief to see the flag posts one
+						if (io_worker_parked_.exchange(false, std::memory_order_acq_rel)) {
+							queue_work_item([] {});
+							return;
+						}
+#endif
+					}
+					else if (v->ready->parked()) {
+						v->ready->wake();
+						return;
+					}
+				}
+			}
+
+			// run until stopped.  w is the worker, or nullptr if single-threaded
+			void loop_(worker_t *w)
+			{
+				size_t& idle_passes = w ? w->idle_passes : idle_passes_;
+				const bool services_io = services_io_(w);
+				while (!stop_request) {
+					// Pending async routines may release (raise) semaphores, run them now, then run all ready schedules.
+					try {
+						const size_t n_callbacks = services_io ? service_all_pending_aio() : 0;
+						size_t n_actions = w ? step_(*w) : step();
+						if (!n_actions && w && work_stealing_)
+							n_actions = steal_(*w);
+						if (n_actions == 0 && n_callbacks == 0)
+							idle(idle_passes, w);
+						else
+							idle_passes = 0;
+
+					} catch (std::error_code &ec) {
+						std::cerr << "Scheduler stopped.  Reason: " << ec.message() << std::endl;
+						if (ec == eng_errc::input_stream_eof)
+							stop_request = true;
+						else
+							throw;
+					}
+				}
+			}
+
+			// run f, reporting any error that stops the scheduler
+			template<class F>void guarded_(F f)
+			{
+				try {
+					f();
+				}
+				catch (std::error_code&  ec) {
+					std::cerr << "Scheduler stopped after an error: " << ec.message() << std::endl;
+
+				}
+				catch (eng_ex& handled_error) {
+					std::cerr << "Scheduler stopped after an error: " << handled_error.what() << std::endl;
+
+				}
+				catch (std::exception& unhandled_error) {
+					std::cerr << "Scheduler stopped after an unexpected error: " << unhandled_error.what() << std::endl;
+
+				}
+				catch (...) {
+					std::cerr << "Scheduler stopped after an unspecified error." << std::endl;
+				}
+			}
+
+			void run_threads_()
+			{
+				partition_();
+				// a worker stopping for any reason stops them all
+				std::vector<std::thread> threads;
+				for (size_t k = 1; k < threads_; ++k)
+					threads.emplace_back([this, k] {
+						guarded_([this, k] { loop_(workers_[k].get()); });
+						stop();
+					});
+				guarded_([this] { loop_(workers_[0].get()); });
+				stop();
+				for (auto& t : threads)
+					t.join();
+
+				std::lock_guard<std::mutex> lock(workers_mutex_);
+				workers_.clear();
+			}
+
 			size_t service_any_pending_aio()
 			{
 #ifdef USE_ASIO
@@ -285,9 +623,30 @@ namespace sel {
 
 			static void queue_work_item(func action) { asio_scheduler::get().queue_work_item(action); }
 
+			// What run() does when it finds nothing to do.  Set before run()
+			void set_idle_policy(idle_policy policy,
+				size_t spin_passes = 10000,
+				std::chrono::nanoseconds park_timeout = std::chrono::milliseconds(100))
+			{
+				idle_policy_ = policy;
+				spin_passes_ = spin_passes;
+				park_timeout_ = park_timeout;
+			}
+			idle_policy get_idle_policy() const { return idle_policy_; }
+
+			// Run the schedules on n threads (1, the default, runs them all on the thread that calls run()).  Set before run()
+			void set_threads(size_t n) { threads_ = n ? n : 1; }
+			size_t threads() const { return threads_; }
+
+			// With more than one thread, let idle workers run other workers' ready schedules.  Set before run()
+			void set_work_stealing(bool on = true) { work_stealing_ = on; }
+			bool work_stealing() const { return work_stealing_; }
+
 			void clear()
 			{
 				schedules.clear();
+				// semaphores still attached to the old list may be raised, but no longer affect this scheduler
+				ready_ = std::make_shared<ready_list>();
 			}
 
 			const schedule *context() const
@@ -303,6 +662,7 @@ namespace sel {
 
 				if (i == schedules.end()) {  // no schedule with this trigger found, add a new chain
 					schedules.push_back(s);
+					attach_(s.trigger_);
 				}
 				else
 					//if ((*i).action == action)
@@ -311,14 +671,15 @@ namespace sel {
 					throw eng_ex("Attempt to add a schedule with same trigger as a registered schedule");
 			}
 			
-			void add(semaphore * trigger, functor& action_)
+			void add(semaphore * trigger, functor& action_, size_t max_block = 1)
 			{
 
 				// find schedule with this trigger
 				auto i = find_if(schedules.begin(), schedules.end(), [trigger](auto s2) -> bool { return s2.trigger_ == trigger; });
 
 				if (i == schedules.end()) {  // no schedule with this trigger found, add a new chain
-					schedules.push_back(schedule(trigger, action_));
+					schedules.push_back(schedule(trigger, action_, max_block));
+					attach_(trigger);
 				}
 				else
 					//if ((*i).action == action)
@@ -336,7 +697,17 @@ namespace sel {
 				return std::thread([=] { run(); });
 			}
 
-			void stop() { stop_request = true; }
+			void stop()
+			{
+				stop_request = true;
+#ifdef USE_ASIO
+				// wake run() if it is parked
+				queue_work_item([] {});
+#endif
+				std::lock_guard<std::mutex> lock(workers_mutex_);
+				for (auto& w : workers_)
+					w->ready->wake();
+			}
 
 			void init()
 			{
@@ -352,11 +723,18 @@ namespace sel {
 			{
 				size_t n_actions_run = 0;
 
-				// Run all ready schedules;
-				for (auto& s : schedules) {
-					if (s.acquire()) {
+				// Run all ready schedules, in the order they were added;  a schedule running blocks drains up to a block
+				// of its semaphore count at once.  Only schedules whose triggers have been raised are visited
+				ready_list& ready = *ready_;
+				for (size_t i = ready.take(0); i != ready_list::npos; i = ready.take(i + 1)) {
+					auto& s = schedules[i];
+					const size_t n = s.acquire_block();
+					// still ready if the count wasn't all taken (if the action raises the trigger, that sets it too)
+					if (s.trigger_->pending())
+						ready.set(i);
+					if (n) {
 						current_context_ = &s;
-						s.action_();
+						s.run(n);
 						++n_actions_run;
 					}
 				}
@@ -368,51 +746,17 @@ namespace sel {
 				if (schedules.size() == 0)
 					throw eng_ex("No schedules to run.");
 
-				try {
-
+				guarded_([this] {
 					init();
 
 					if (do_measure_performance_at_start)
 						start_performance_measure();
-					
-					while (!stop_request) {
-						// wait for a user event
-						// Pending async routines may release (raise) semaphores, run one now
-						
-						// Run all ready schedules;
-
-						try {
-							service_all_pending_aio();
-                            step();
-
-						} catch (std::error_code &ec) {
-							std::cerr << "Scheduler stopped.  Reason: " << ec.message() << std::endl;
-							if (ec == eng_errc::input_stream_eof)
-								stop_request = true;
-							else
-								throw;
-						}
-	
 
-						
-
-					}
-				}
-				catch (std::error_code&  ec) {
-					std::cerr << "Scheduler stopped after an error: " << ec.message() << std::endl;
-
-				}
-				catch (eng_ex& handled_error) {
-					std::cerr << "Scheduler stopped after an error: " << handled_error.what() << std::endl;
-
-				}
-				catch (std::exception& unhandled_error) {
-					std::cerr << "Scheduler stopped after an unexpected error: " << unhandled_error.what() << std::endl;
-
-				}
-				catch (...) {
-					std::cerr << "Scheduler stopped after an unspecified error." << std::endl;
-				}
+					if (threads_ > 1)
+						run_threads_();
+					else
+						loop_(nullptr);
+				});
 
 				try {
                     // If any schedule actions are processors, run their term() routines
@@ -509,6 +853,218 @@ void run()
 
 }
 
+SEL_UNIT_TEST_END
+
+SEL_UNIT_TEST(scheduler)
+
+struct ut_traits
+{
+	static constexpr size_t fibers = 200;
+	static constexpr size_t mt_threads = 4;
+	static constexpr size_t mt_fibers = 8;
+	static constexpr size_t mt_ticks = 2000;
+};
+
+// records the order the schedules run in
+struct log_action : sel::eng6::processor
+{
+	std::vector<size_t>& log;
+	const size_t id;
+	log_action(std::vector<size_t>& log, size_t id) : log(log), id(id) {}
+	void process() final { log.push_back(id); }
+};
+
+// stops the scheduler after some ticks
+struct stop_after : sel::eng6::processor
+{
+	sel::eng6::scheduler& scheduler_;
+	size_t ticks_remaining;
+	stop_after(sel::eng6::scheduler& s, size_t ticks) : scheduler_(s), ticks_remaining(ticks) {}
+	void process() final
+	{
+		if (!--ticks_remaining)
+			scheduler_.stop();
+	}
+};
+
+// run only by invoke() from a root_action, like the output of a resampler or window
+struct invoked_action : sel::eng6::processor
+{
+	sel::eng6::schedule *context = nullptr;
+	size_t ticks = 0;
+	std::thread::id thread;
+	void init(sel::eng6::schedule *context) final
+	{
+		this->context = context;
+		context->set_invoked();
+	}
+	void process() final
+	{
+		++ticks;
+		thread = std::this_thread::get_id();
+	}
+};
+
+// counts its ticks, notes if they ran on more than one thread, and stops the scheduler after the last tick of all
+struct root_action : sel::eng6::processor
+{
+	sel::eng6::scheduler& scheduler_;
+	std::atomic<size_t>& ticks_remaining;
+	invoked_action *downstream;
+	size_t ticks = 0;
+	std::thread::id thread;
+	bool moved = false;
+	bool downstream_moved = false;
+	root_action(sel::eng6::scheduler& s, std::atomic<size_t>& ticks_remaining, invoked_action *downstream) :
+		scheduler_(s), ticks_remaining(ticks_remaining), downstream(downstream) {}
+	void process() final
+	{
+		const auto id = std::this_thread::get_id();
+		if (ticks++ && id != thread)
+			moved = true;
+		thread = id;
+		if (downstream) {
+			downstream->context->invoke();
+			downstream_moved |= downstream->thread != id;
+		}
+		if (--ticks_remaining == 0)
+			scheduler_.stop();
+	}
+};
+
+// notes if it is ever run on two threads at once, or its ticks out of order, and the threads it ran on
+struct exclusive_action : sel::eng6::processor
+{
+	sel::eng6::scheduler& scheduler_;
+	std::atomic<size_t>& ticks_remaining;
+	const size_t cost;
+	std::atomic<int> running{ 0 };
+	size_t ticks = 0;
+	std::atomic<size_t> ticks_seen{ 0 };
+	bool overlapped = false;
+	std::vector<std::thread::id> threads;
+	exclusive_action(sel::eng6::scheduler& s, std::atomic<size_t>& ticks_remaining, size_t cost) :
+		scheduler_(s), ticks_remaining(ticks_remaining), cost(cost) {}
+	void process() final
+	{
+		if (running.fetch_add(1) != 0)
+			overlapped = true;
+		// plain counter, checked against an atomic one:  a race between two workers would lose updates
+		++ticks;
+		++ticks_seen;
+		const auto id = std::this_thread::get_id();
+		if (std::find(threads.begin(), threads.end(), id) == threads.end())
+			threads.push_back(id);
+		volatile size_t sink = 0;
+		for (size_t i = 0; i < cost; ++i)
+			sink = sink + i;
+		running.fetch_sub(1);
+		if (--ticks_remaining == 0)
+			scheduler_.stop();
+	}
+};
+
+void run()
+{
+	std::vector<size_t> log;
+	std::vector<sel::eng6::semaphore> triggers(ut_traits::fibers);
+	std::vector<log_action> actions;
+	for (size_t i = 0; i < ut_traits::fibers; ++i)
+		actions.emplace_back(log, i);
+
+	// one trigger raised before its schedule is added
+	triggers[150].raise();
+
+	sel::eng6::scheduler s = {};
+	for (size_t i = 0; i < ut_traits::fibers; ++i)
+		s.add(&triggers[i], actions[i]);
+	s.init();
+
+	SEL_UNIT_TEST_ITEM("ready list order");
+	triggers[130].raise();
+	triggers[3].raise(2);
+	triggers[64].raise();
+	SEL_UNIT_TEST_ASSERT(s.step() == 4);
+	SEL_UNIT_TEST_ASSERT((log == std::vector<size_t>{ 3, 64, 130, 150 }));
+
+	SEL_UNIT_TEST_ITEM("ready until the count is taken");
+	log.clear();
+	SEL_UNIT_TEST_ASSERT(s.step() == 1);
+	SEL_UNIT_TEST_ASSERT(s.step() == 0);
+	SEL_UNIT_TEST_ASSERT((log == std::vector<size_t>{ 3 }));
+
+	SEL_UNIT_TEST_ITEM("cleared scheduler");
+	s.clear();
+	triggers[7].raise();
+	SEL_UNIT_TEST_ASSERT(s.step() == 0);
+
+	// every tick of a periodic event still runs its schedule, whether or not the scheduler parks between ticks
+	SEL_UNIT_TEST_ITEM("idle policies");
+	for (auto policy : { sel::eng6::idle_policy::spin, sel::eng6::idle_policy::spin_then_park, sel::eng6::idle_policy::block }) {
+		sel::eng6::periodic_event tick(rate_t(1000, 1));
+		stop_after action(s, 20);
+		s.set_idle_policy(policy, 100);
+		s.add(&tick, action);
+		s.run();
+		SEL_UNIT_TEST_ASSERT(action.ticks_remaining == 0);
+	}
+
+	// each fiber stays on one worker, and an invoked fiber runs on the worker of the fiber invoking it
+	SEL_UNIT_TEST_ITEM("worker threads");
+	{
+		std::atomic<size_t> ticks_remaining{ ut_traits::mt_fibers * ut_traits::mt_ticks };
+		std::vector<sel::eng6::semaphore> roots(ut_traits::mt_fibers), outputs(ut_traits::mt_fibers);
+		std::vector<invoked_action> downstream(ut_traits::mt_fibers);
+		std::vector<root_action> fibers;
+		for (size_t i = 0; i < ut_traits::mt_fibers; ++i)
+			fibers.emplace_back(s, ticks_remaining, i % 2 ? &downstream[i] : nullptr);
+		for (size_t i = 0; i < ut_traits::mt_fibers; ++i) {
+			roots[i].raise(ut_traits::mt_ticks);
+			s.add(&roots[i], fibers[i]);
+			s.add(&outputs[i], downstream[i]);
+		}
+		s.set_threads(ut_traits::mt_threads);
+		s.set_idle_policy(sel::eng6::idle_policy::spin_then_park, 100);
+		s.run();
+		s.set_threads(1);
+
+		std::vector<std::thread::id> threads;
+		for (size_t i = 0; i < ut_traits::mt_fibers; ++i) {
+			SEL_UNIT_TEST_ASSERT(fibers[i].ticks == ut_traits::mt_ticks && !fibers[i].moved);
+			SEL_UNIT_TEST_ASSERT(downstream[i].ticks == (i % 2 ? ut_traits::mt_ticks : 0) && !fibers[i].downstream_moved);
+			if (std::find(threads.begin(), threads.end(), fibers[i].thread) == threads.end())
+				threads.push_back(fibers[i].thread);
+		}
+		SEL_UNIT_TEST_ASSERT(threads.size() == ut_traits::mt_threads);
+	}
+
+	// the expensive fibers (0 and 4) both start on worker 0, which runs on this thread, so the other workers steal them
+	SEL_UNIT_TEST_ITEM("work stealing");
+	{
+		std::atomic<size_t> ticks_remaining{ ut_traits::mt_fibers * ut_traits::mt_ticks };
+		std::vector<sel::eng6::semaphore> triggers(ut_traits::mt_fibers);
+		std::vector<std::unique_ptr<exclusive_action>> fibers;
+		for (size_t i = 0; i < ut_traits::mt_fibers; ++i) {
+			fibers.push_back(std::make_unique<exclusive_action>(s, ticks_remaining, i % ut_traits::mt_threads ? 10 : 1000));
+			triggers[i].raise(ut_traits::mt_ticks);
+			s.add(&triggers[i], *fibers[i]);
+		}
+		s.set_threads(ut_traits::mt_threads);
+		s.set_work_stealing();
+		s.run();
+		s.set_threads(1);
+		s.set_work_stealing(false);
+
+		for (auto& f : fibers)
+			SEL_UNIT_TEST_ASSERT(!f->overlapped && f->ticks == ut_traits::mt_ticks && f->ticks_seen == ut_traits::mt_ticks);
+		const auto worker0 = std::this_thread::get_id();
+		auto stolen = [worker0](const exclusive_action& f) {
+			return std::find_if(f.threads.begin(), f.threads.end(), [worker0](std::thread::id id) { return id != worker0; }) != f.threads.end();
+		};
+		SEL_UNIT_TEST_ASSERT(stolen(*fibers[0]) || stolen(*fibers[ut_traits::mt_threads]));
+	}
+}
+
 SEL_UNIT_TEST_END
 #endif
 
@@ -0,0 +1,243 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include "idx.h"
+#include "mirrored_buffer.h"
+
+namespace sel {
+	/*
+	Lock-free single-producer / single-consumer queue, for passing data between two threads (e.g. an I/O thread and a DSP thread).
+	One thread may call only the producer functions, one other thread only the consumer functions.  Nothing is ever dropped:
+	the try_ functions return false, and the others throw, if there is not enough data or room.
+
+	The interface follows quick_queue:
+	producer:	put(), try_put(), atomicwrite(), try_write(),
+				acquirewrite() / endwrite(n)	(a contiguous span of put_avail() free elements, then commit n of them),
+				reserve(n) / commit(n)			(as acquirewrite / endwrite, but reserve() returns nullptr if fewer than n are free)
+	consumer:	get(), try_get(), atomicread_into(), try_read(),
+				acquireread() / endread(n)		(a contiguous span of get_avail() elements, then release n of them)
+
+	head_ (elements ever written) and tail_ (elements ever read) are each written by one side only, with release ordering,
+	and read by the other with acquire ordering.  Each side keeps its own index and a cached copy of the other's on its own
+	cache line, and only reloads the other's index when the cached one says the queue is full (or empty).
+
+	Spans are contiguous as in quick_queue:  the storage is a mirrored_buffer if the queue's bytes are a multiple of the
+	page size and T is trivially copyable, otherwise a vector twice the size, in which the producer writes every element
+	to both halves (the consumer never writes).
+	*/
+	template<typename T, const size_t SZ = dynamic_size_v>class spsc_queue
+	{
+		static_assert(std::is_default_constructible<T>::value, "spsc_queue: T must be default constructible");
+
+		static constexpr size_t cache_line = 64;
+		static constexpr bool can_mirror = std::is_trivially_copyable<T>::value;
+
+		const size_t capacity_;
+		mirrored_buffer mirror_;
+		std::vector<T> vbuf_;
+		T *buf_ = nullptr;
+		bool mirrored_ = false;
+
+		// producer's line
+		alignas(cache_line) std::atomic<size_t> head_{ 0 };
+		size_t tail_cache_ = 0;
+
+		// consumer's line
+		alignas(cache_line) std::atomic<size_t> tail_{ 0 };
+		size_t head_cache_ = 0;
+
+		alignas(cache_line) char pad_[cache_line] = {};
+
+		static void copy_(const T *from, size_t howmany, T *to)
+		{
+			if (!howmany)
+				return;
+			if constexpr (std::is_trivially_copyable<T>::value)
+				std::memcpy(to, from, howmany * sizeof(T));
+			else
+				std::copy(from, from + howmany, to);
+		}
+
+		// producer: free elements, reloading tail_ only if the cached value is not enough
+		size_t free_(size_t head, size_t wanted)
+		{
+			if (capacity_ - (head - tail_cache_) < wanted)
+				tail_cache_ = tail_.load(std::memory_order_acquire);
+			return capacity_ - (head - tail_cache_);
+		}
+
+		// consumer: available elements, reloading head_ only if the cached value is not enough
+		size_t avail_(size_t tail, size_t wanted)
+		{
+			if (head_cache_ - tail < wanted)
+				head_cache_ = head_.load(std::memory_order_acquire);
+			return head_cache_ - tail;
+		}
+
+		// producer, not mirrored:  elements [pos, pos + howmany) of the doubled buffer were written;  copy them to the other half
+		void mirror_written_(size_t pos, size_t howmany)
+		{
+			const size_t first = std::min(howmany, capacity_ - pos);
+			copy_(buf_ + pos, first, buf_ + pos + capacity_);
+			copy_(buf_ + capacity_, howmany - first, buf_);
+		}
+
+	public:
+		explicit spsc_queue(size_t capacity = SZ) : capacity_(capacity)
+		{
+			if (SZ != dynamic_size_v && capacity > SZ)
+				throw std::runtime_error("spsc_queue: capacity cannot be > SZ");
+			if (capacity == 0 || capacity == dynamic_size_v)
+				throw std::runtime_error("spsc_queue: capacity must be given, and nonzero");
+
+			if (can_mirror && mirrored_buffer::supported(capacity_ * sizeof(T))) {
+				try {
+					mirror_ = mirrored_buffer(capacity_ * sizeof(T));
+					buf_ = static_cast<T *>(mirror_.data());
+					mirrored_ = true;
+				} catch (std::runtime_error&) {
+					// fall back to the vector
+				}
+			}
+			if (!mirrored_) {
+				vbuf_.resize(2 * capacity_);
+				buf_ = vbuf_.data();
+			}
+		}
+
+		spsc_queue(const spsc_queue&) = delete;
+		spsc_queue& operator=(const spsc_queue&) = delete;
+
+		size_t size() const { return capacity_; }
+		bool is_mirrored() const { return mirrored_; }
+
+		// approximate from any thread other than the caller's own side;  exact for the side that asks about its own limit
+		size_t get_avail() const { return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire); }
+		size_t put_avail() const { return capacity_ - get_avail(); }
+		bool isempty() const { return get_avail() == 0; }
+		bool isfull() const { return get_avail() == capacity_; }
+
+		////// producer
+
+		// a contiguous span of put_avail() free elements.  Fill some, then endwrite() how many
+		T *acquirewrite()
+		{
+			return buf_ + head_.load(std::memory_order_relaxed) % capacity_;
+		}
+
+		void endwrite(size_t howmany)
+		{
+			const size_t head = head_.load(std::memory_order_relaxed);
+			if (free_(head, howmany) < howmany)
+				throw std::runtime_error("spsc_queue::endwrite: cannot write all requested data");
+			if (!mirrored_)
+				mirror_written_(head % capacity_, howmany);
+			head_.store(head + howmany, std::memory_order_release);
+		}
+
+		// span of howmany free elements, or nullptr if there are fewer
+		T *reserve(size_t howmany)
+		{
+			const size_t head = head_.load(std::memory_order_relaxed);
+			return free_(head, howmany) < howmany ? nullptr : buf_ + head % capacity_;
+		}
+
+		void commit(size_t howmany) { endwrite(howmany); }
+
+		bool try_write(const T *data, size_t howmany)
+		{
+			T *span = reserve(howmany);
+			if (!span)
+				return false;
+			copy_(data, howmany, span);
+			commit(howmany);
+			return true;
+		}
+
+		void atomicwrite(const T *data, size_t howmany)
+		{
+			if (!try_write(data, howmany))
+				throw std::runtime_error("spsc_queue::atomicwrite: cannot write all requested data");
+		}
+
+		template<typename VectorLikeT> void atomicwrite(const VectorLikeT& vec)
+		{
+			atomicwrite(vec.data(), vec.size());
+		}
+
+		bool try_put(const T& v) { return try_write(&v, 1); }
+
+		void put(const T& v)
+		{
+			if (!try_put(v))
+				throw std::runtime_error("spsc_queue::put: buffer is full");
+		}
+
+		////// consumer
+
+		// a contiguous span of get_avail() elements.  Use some, then endread() how many
+		const T *acquireread()
+		{
+			return buf_ + tail_.load(std::memory_order_relaxed) % capacity_;
+		}
+
+		void endread(size_t howmany)
+		{
+			const size_t tail = tail_.load(std::memory_order_relaxed);
+			if (avail_(tail, howmany) < howmany)
+				throw std::runtime_error("spsc_queue::endread: cannot read all requested data");
+			tail_.store(tail + howmany, std::memory_order_release);
+		}
+
+		// span of howmany elements, or nullptr if there are fewer.  Release them with endread()
+		const T *peek(size_t howmany)
+		{
+			const size_t tail = tail_.load(std::memory_order_relaxed);
+			return avail_(tail, howmany) < howmany ? nullptr : buf_ + tail % capacity_;
+		}
+
+		bool try_read(T *dest, size_t howmany)
+		{
+			const T *span = peek(howmany);
+			if (!span)
+				return false;
+			copy_(span, howmany, dest);
+			endread(howmany);
+			return true;
+		}
+
+		void atomicread_into(T *dest, size_t howmany)
+		{
+			if (!try_read(dest, howmany))
+				throw std::runtime_error("spsc_queue::atomicread_into: cannot read all requested data");
+		}
+
+		template<typename Iterable>void atomicread_into(Iterable& dest)
+		{
+			const size_t howmany = static_cast<size_t>(dest.end() - dest.begin());
+			const T *span = peek(howmany);
+			if (!span)
+				throw std::runtime_error("spsc_queue::atomicread_into: cannot read all requested data");
+			std::copy(span, span + howmany, dest.begin());
+			endread(howmany);
+		}
+
+		bool try_get(T& v) { return try_read(&v, 1); }
+
+		T get()
+		{
+			T v;
+			if (!try_get(v))
+				throw std::runtime_error("spsc_queue::get: buffer is empty");
+			return v;
+		}
+	};
+
+} // sel
+#if defined(COMPILE_UNIT_TESTS)
+#include "spsc_queue_ut.h"
+#endif
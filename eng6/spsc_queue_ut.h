@@ -0,0 +1,112 @@
+#pragma once
+
+// single-producer / single-consumer queue unit test
+#include "spsc_queue.h"
+#include <thread>
+#include <vector>
+#include "unit_test.h"
+SEL_UNIT_TEST(spsc_queue)
+
+struct ut_traits
+{
+	static constexpr size_t items = 500000;
+	static constexpr size_t odd_queue_size = 1000;		// vector storage
+	static constexpr size_t page_queue_size = 4096 / sizeof(uint64_t);	// mirrored storage, on Linux
+};
+
+// The producer writes 0, 1, 2, ... in batches of varying size, using each of the producer interfaces in turn,
+// the consumer reads in batches of other sizes.  Returns the number of items that arrived out of order.
+template<class Queue>size_t stress(Queue& q)
+{
+	std::thread producer([&q] {
+		uint64_t next = 0;
+		size_t batch = 1;
+		while (next < ut_traits::items) {
+			const size_t n = std::min<size_t>(batch, ut_traits::items - next);
+			const uint64_t before = next;
+			switch (batch % 3) {
+			case 0:
+				if (auto *span = q.reserve(n)) {
+					for (size_t i = 0; i < n; ++i)
+						span[i] = next++;
+					q.commit(n);
+				}
+				break;
+			case 1: {
+				if (q.put_avail() >= n) {
+					auto *span = q.acquirewrite();
+					for (size_t i = 0; i < n; ++i)
+						span[i] = next++;
+					q.endwrite(n);
+				}
+				break;
+			}
+			default:
+				if (q.try_put(next))
+					++next;
+				break;
+			}
+			batch = batch % 37 + 1;
+			if (next == before)
+				std::this_thread::yield();
+		}
+	});
+
+	size_t errors = 0;
+	uint64_t expected = 0;
+	size_t batch = 1;
+	std::vector<uint64_t> block(64);
+	while (expected < ut_traits::items) {
+		const size_t n = std::min<size_t>(batch, ut_traits::items - expected);
+		const uint64_t before = expected;
+		if (batch % 2) {
+			if (q.try_read(block.data(), n))
+				for (size_t i = 0; i < n; ++i)
+					errors += block[i] != expected++;
+		} else if (const auto *span = q.peek(n)) {
+			for (size_t i = 0; i < n; ++i)
+				errors += span[i] != expected++;
+			q.endread(n);
+		}
+		batch = batch % 53 + 1;
+		if (expected == before)
+			std::this_thread::yield();
+	}
+	producer.join();
+	return errors + !q.isempty();
+}
+
+void run()
+{
+	SEL_UNIT_TEST_ITEM("single thread");
+	sel::spsc_queue<uint64_t> q0(5);
+	SEL_UNIT_TEST_ASSERT(q0.try_put(1) && q0.try_put(2));
+	const uint64_t three[3] = { 3, 4, 5 };
+	SEL_UNIT_TEST_ASSERT(q0.try_write(three, 3));
+	SEL_UNIT_TEST_ASSERT(q0.isfull());
+	SEL_UNIT_TEST_ASSERT(!q0.try_put(6));
+	SEL_UNIT_TEST_ASSERT(q0.reserve(1) == nullptr);
+	uint64_t v = 0;
+	for (uint64_t i = 1; i <= 5; ++i)
+		SEL_UNIT_TEST_ASSERT(q0.try_get(v) && v == i);
+	SEL_UNIT_TEST_ASSERT(!q0.try_get(v));
+	// contiguous span across the end of the buffer
+	SEL_UNIT_TEST_ASSERT(q0.try_write(three, 3));
+	const auto *span = q0.peek(3);
+	SEL_UNIT_TEST_ASSERT(span && span[0] == 3 && span[1] == 4 && span[2] == 5);
+	q0.endread(3);
+
+	SEL_UNIT_TEST_ITEM("two threads, vector storage");
+	sel::spsc_queue<uint64_t, ut_traits::odd_queue_size> q1;
+	SEL_UNIT_TEST_ASSERT(!q1.is_mirrored());
+	SEL_UNIT_TEST_ASSERT(stress(q1) == 0);
+
+	SEL_UNIT_TEST_ITEM("two threads, mirrored storage");
+	sel::spsc_queue<uint64_t> q2(ut_traits::page_queue_size);
+#if defined(__linux__)
+	SEL_UNIT_TEST_ASSERT(q2.is_mirrored());
+#endif
+	SEL_UNIT_TEST_ASSERT(stress(q2) == 0);
+}
+
+SEL_UNIT_TEST_END
@@ -152,7 +152,10 @@ namespace sel {
 					if (!action_)
 						throw eng_ex(format_message("Couldn't add schedule: %s is not a schedule action (functor).", action_id.c_str()));
 
-					eng6::scheduler::get().add(trigger_, *action_);
+					// optional:  most ticks per call, if the action can process blocks
+					const auto block = create_params.get<size_t>("block", 1);
+
+					eng6::scheduler::get().add(trigger_, *action_, block);
 
 				}
 				return true;
@@ -10,10 +10,6 @@
 
 #define USE_OPENCV_DNN
 
-template<class T>T&& heap_alloc() {
-    return std::move(*std::make_unique<T>());
-}
-
 struct pix2pix {
     static constexpr size_t sr = 16000;
     static constexpr size_t n_fft = 512;
@@ -41,12 +37,12 @@ struct pix2pix {
     input_t pix2pix_input;
     output_t pix2pix_output;
 
-    MelSpec&& melspec;
+    // cheap to construct: the filter bank is shared, from mel_filterbank_cache
+    MelSpec melspec;
     const int batch_size;
 
     pix2pix(const int batch_size) :
-    batch_size(batch_size),
-    melspec(heap_alloc<MelSpec>())
+    batch_size(batch_size)
     {
 
     }
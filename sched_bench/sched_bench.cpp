@@ -0,0 +1,123 @@
+//
+// Multi-threaded scheduler benchmark:  throughput of fibers with uneven costs, with the schedules statically partitioned
+// onto the worker threads, and with work stealing.
+// In the skewed load, every fiber dealt to worker 0 costs 100 times as much per tick as the others, so with a static
+// partition worker 0 does most of the work while the others sit idle.
+// Besides ticks per second, the benchmark reports the largest share of the work done by any one thread.  Run time on
+// dedicated cores is bounded below by that share, so it shows the balance even when the threads share fewer cores.
+//
+// usage: sched_bench [threads]		(default: the number of hardware threads, at least 2)
+//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../eng6/scheduler.h"
+
+constexpr size_t FIBERS = 16;
+constexpr size_t TICKS = 2000;	// per fiber
+constexpr size_t LIGHT_COST = 2000;
+
+// work done by each thread
+struct work_log
+{
+	std::mutex mutex;
+	std::map<std::thread::id, size_t> work;
+
+	void add(size_t cost)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		work[std::this_thread::get_id()] += cost;
+	}
+
+	double largest_share()
+	{
+		size_t total = 0, largest = 0;
+		for (auto& w : work) {
+			total += w.second;
+			largest = std::max(largest, w.second);
+		}
+		return static_cast<double>(largest) / total;
+	}
+};
+
+// does cost units of work per tick, and stops the scheduler after the last tick of all fibers
+struct busy_fiber : sel::eng6::processor
+{
+	sel::eng6::scheduler& scheduler_;
+	std::atomic<size_t>& ticks_remaining_;
+	work_log& log_;
+	const size_t cost_;
+	double sink = 0;
+
+	busy_fiber(sel::eng6::scheduler& s, std::atomic<size_t>& ticks_remaining, work_log& log, size_t cost) :
+		scheduler_(s), ticks_remaining_(ticks_remaining), log_(log), cost_(cost) {}
+
+	void process() final
+	{
+		double x = sink;
+		for (size_t i = 0; i < cost_; ++i)
+			x = x * 0.999999 + 1.0;
+		sink = x;
+		log_.add(cost_);
+		if (--ticks_remaining_ == 0)
+			scheduler_.stop();
+	}
+};
+
+struct result
+{
+	double ticks_per_second;
+	double largest_share;
+};
+
+result run(size_t threads, bool work_stealing, const std::vector<size_t>& costs)
+{
+	work_log log;
+	sel::eng6::scheduler s = {};
+	std::atomic<size_t> ticks_remaining{ costs.size() * TICKS };
+	std::vector<sel::eng6::semaphore> triggers(costs.size());
+	std::vector<std::unique_ptr<busy_fiber>> fibers;
+	for (size_t i = 0; i < costs.size(); ++i) {
+		fibers.push_back(std::make_unique<busy_fiber>(s, ticks_remaining, log, costs[i]));
+		triggers[i].raise(TICKS);
+		s.add(&triggers[i], *fibers[i]);
+	}
+	s.set_threads(threads);
+	s.set_work_stealing(work_stealing);
+	s.set_idle_policy(sel::eng6::idle_policy::spin_then_park, 1000, std::chrono::milliseconds(1));
+
+	const auto start = std::chrono::steady_clock::now();
+	s.run();
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return { costs.size() * TICKS / elapsed.count(), log.largest_share() };
+}
+
+int main(int argc, char *argv[])
+{
+	const size_t threads = argc > 1 ? std::max<size_t>(2, atoi(argv[1])) : std::max<size_t>(2, std::thread::hardware_concurrency());
+	printf("%zu fibers, %zu ticks each, %zu threads\n", FIBERS, TICKS, threads);
+
+	std::vector<size_t> uniform(FIBERS, LIGHT_COST), skewed(FIBERS, LIGHT_COST);
+	// schedules are dealt out to the workers in turn:  fibers 0, threads, 2 * threads ... start on worker 0
+	for (size_t i = 0; i < FIBERS; i += threads)
+		skewed[i] = 100 * LIGHT_COST;
+
+	for (auto load : { &uniform, &skewed }) {
+		const result partitioned = run(threads, false, *load);
+		const result stealing = run(threads, true, *load);
+		printf("%-8s load:  static partition %10.0f ticks/s (busiest thread %3.0f%% of work),  "
+			"work stealing %10.0f ticks/s (busiest thread %3.0f%%):  x%.2f\n",
+			load == &uniform ? "uniform" : "skewed",
+			partitioned.ticks_per_second, 100 * partitioned.largest_share,
+			stealing.ticks_per_second, 100 * stealing.largest_share,
+			stealing.ticks_per_second / partitioned.ticks_per_second);
+	}
+	return 0;
+}
@@ -0,0 +1,93 @@
+//
+// Sliding DFT benchmark:  eng6::proc::sdft against recomputing the spectrum with GFFT for every new sample.
+// (sdft.cpp is the original prototype, which also compares against FFTW.)
+//
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <vector>
+#include "../eng6/scheduler.h"
+#include "../eng6/procs/rand.h"
+#include "../eng6/procs/sdft.h"
+
+// samples per run
+constexpr size_t NSAMPS = 200000;
+
+template<class F>double samples_per_second(F&& per_sample)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < NSAMPS; ++i)
+		per_sample();
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return NSAMPS / elapsed.count();
+}
+
+template<unsigned N>void bench()
+{
+	using namespace sel::eng6::proc;
+
+	// sdft, all N/2+1 bins
+	sel::eng6::proc::rand<1> rng;
+	sdft sdft_all(N);
+	rng.ConnectTo(sdft_all);
+	rng.freeze();
+	sdft_all.freeze();
+	std::deque<samp_t> last(N, 0.0);
+	const double sdft_rate = samples_per_second([&] {
+		rng.process();
+		sdft_all.process();
+		last.pop_front();
+		last.push_back(rng.out[0]);
+	});
+
+	// sdft, 16 bins
+	sel::eng6::proc::rand<1> rng16;
+	sdft sdft_16(N, N / 8, 16);
+	rng16.ConnectTo(sdft_16);
+	rng16.freeze();
+	sdft_16.freeze();
+	const double sdft16_rate = samples_per_second([&] {
+		rng16.process();
+		sdft_16.process();
+	});
+
+	// GFFT of the whole window, for every sample
+	sel::eng6::proc::rand<1> rng_gfft;
+	rng_gfft.freeze();
+	GFFT<N, samp_t, 1> gfft;
+	std::vector<samp_t> window(N, 0.0);
+	std::vector<samp_t> freqs(2 * N);
+	size_t pos = 0;
+	const double gfft_rate = samples_per_second([&] {
+		rng_gfft.process();
+		window[pos] = rng_gfft.out[0];
+		pos = (pos + 1) % N;
+		for (size_t i = 0; i < N; ++i) {
+			freqs[2 * i] = window[(pos + i) % N];
+			freqs[2 * i + 1] = 0;
+		}
+		gfft.fft(freqs.data());
+	});
+
+	// check the sdft against a fresh fft of the same samples
+	std::vector<samp_t> x(2 * N, 0.0);
+	for (size_t i = 0; i < N; ++i)
+		x[2 * i] = last[i];
+	gfft.fft(x.data());
+	double max_diff = 0;
+	for (size_t k = 0; k < 2 * (N / 2 + 1); ++k)
+		max_diff = std::max(max_diff, std::abs(sdft_all.out[k] - x[k]));
+
+	printf("N = %5u:  SDFT %10.0f, SDFT (16 bins) %10.0f, GFFT %10.0f spectra per second.  SDFT/GFFT max diff %g\n",
+		N, sdft_rate, sdft16_rate, gfft_rate, max_diff);
+}
+
+int main()
+{
+	printf("fft kernels: %s\n", simd::isa_name(simd::active_isa()));
+	bench<64>();
+	bench<256>();
+	bench<1024>();
+	bench<4096>();
+	return 0;
+}
@@ -20,18 +20,24 @@ int main()
 {
 
     SEL_UNIT_TEST_SUITE_BEGIN
-//    SEL_RUN_UNIT_TEST(ac)
-//	SEL_RUN_UNIT_TEST(dct)
-//	SEL_RUN_UNIT_TEST(fft)
+    SEL_RUN_UNIT_TEST(ac)
+	SEL_RUN_UNIT_TEST(dct)
+	SEL_RUN_UNIT_TEST(fft)
+	SEL_RUN_UNIT_TEST(sdft)
     SEL_RUN_UNIT_TEST(melspec)
+    SEL_RUN_UNIT_TEST(mfcc)
 	SEL_RUN_UNIT_TEST(lattice_filter)
 //	SEL_RUN_UNIT_TEST(periodic_event)
+	SEL_RUN_UNIT_TEST(scheduler)
 //    SEL_RUN_UNIT_TEST(resampler)
     SEL_RUN_UNIT_TEST(window)
-//	SEL_RUN_UNIT_TEST(quick_queue)
+	SEL_RUN_UNIT_TEST(quick_queue)
+	SEL_RUN_UNIT_TEST(spsc_queue)
+	SEL_RUN_UNIT_TEST(mpmc_queue)
+	SEL_RUN_UNIT_TEST(fan_in)
 //	SEL_RUN_UNIT_TEST(rand)
 SEL_RUN_UNIT_TEST(filter)
-//	SEL_RUN_UNIT_TEST(fir_filt)
+	SEL_RUN_UNIT_TEST(fir_filt)
 SEL_RUN_UNIT_TEST(iir_filt)
 //  SEL_RUN_UNIT_TEST(dnn)
 //	SEL_RUN_UNIT_TEST(ewma)